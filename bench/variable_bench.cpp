@@ -0,0 +1,67 @@
+// Times AtomicVariable::get() against a mutex-guarded read, with and without a writer on another thread
+// Host numbers only show the relative cost, FreeRTOS mutexes on the ESP32 are slower still than std::mutex here
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include "variable.h"
+
+#define READS 20000000
+
+// Plain value behind a mutex, how settings were read before they moved to AtomicVariable
+class MutexVariable {
+public:
+  void set(int newValue) {
+    std::lock_guard<std::mutex> lock(mutex);
+    value = newValue;
+  }
+
+  int get() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return value;
+  }
+
+private:
+  std::mutex mutex;
+  int value = 0;
+};
+
+// Time READS calls of read, optionally with another thread setting the value continuously
+// Returns ns per read
+template<typename Variable> double timeReads(Variable &variable, bool contended) {
+  std::atomic<bool> stop(false);
+  std::thread writer;
+  if (contended) {
+    writer = std::thread([&]() {
+      int i = 0;
+      while (!stop.load(std::memory_order_relaxed)) variable.set(i++);
+    });
+  }
+
+  // Summed so reads can't be optimised away
+  volatile long sink = 0;
+  long total = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < READS; i++) {
+    total += variable.get();
+  }
+  auto end = std::chrono::steady_clock::now();
+  sink = total;
+  (void)sink;
+
+  stop.store(true);
+  if (contended) writer.join();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / READS;
+}
+
+int main() {
+  AtomicVariable<int> atomicVariable(0);
+  MutexVariable mutexVariable;
+
+  printf("%-12s %14s %14s\n", "read", "ns uncontended", "ns contended");
+  printf("%-12s %14.2f %14.2f\n", "atomic", timeReads(atomicVariable, false), timeReads(atomicVariable, true));
+  printf("%-12s %14.2f %14.2f\n", "mutex", timeReads(mutexVariable, false), timeReads(mutexVariable, true));
+  return 0;
+}
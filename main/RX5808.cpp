@@ -1,184 +1,800 @@
 #include "RX5808.h"
 
-// Initialise RX5808 receiver
-RX5808::RX5808(uint8_t data, uint8_t le, uint8_t clk, uint8_t rssi, Settings *s)
-  : rssiValues(0), lowband(false),
-    dataPin(data), lePin(le), clkPin(clk), rssiPin(rssi),
-    scanHandle(NULL), stopRequested(false), settings(s) {
-
-  // Setup spi pins
-  pinMode(dataPin, OUTPUT);
-  pinMode(lePin, OUTPUT);
-  pinMode(clkPin, OUTPUT);
-
-  // Setup rssi pin
-  pinMode(rssiPin, INPUT);
+// Initialise RX5808 receivers
+// Takes arrays of a transport and rssi pin for each module
+RX5808::RX5808(RegisterTransport **t, const uint8_t *rssi, int m, Settings *s)
+  : lowband(false), focusFrequency(0), finderFrequency(0), finderRssi(0), autoTuning(false), settleTime(0),
+    modules(std::clamp(m, 1, MAX_RX5808_MODULES)),
+#ifdef CONTINUOUS_RSSI_ADC
+    rssiAdc(rssi[0], RSSI_REDUCTION),
+#endif
+    noiseFloor(0), activeCursor(0),
+    publishedSweep(0), scanHandle(NULL), running(false), autoTuneRequested(false),
+    calibrationRequest(NO_CALIBRATION), traceResetRequested(false), stepTimer(NULL), finderCount(0), finderStart(0), lastSweepTime(0), settings(s) {
+
+  for (int i = 0; i < modules; i++) {
+    transports[i] = t[i];
+    rssiPins[i] = rssi[i];
+  }
 
-  // Set inital pin state
-  digitalWrite(lePin, HIGH);
-  digitalWrite(clkPin, LOW);
+  // Start with empty high band sweeps that nothing has borrowed
+  ScanConfig initial = {};
+  initial.mode = BAND;
+  initial.minFrequency = HIGHBAND_MIN_FREQUENCY;
+  initial.maxFrequency = HIGHBAND_MIN_FREQUENCY + SCAN_FREQUENCY_RANGE;
+  initial.intervalKhz = DEFAULT_SCAN_INTERVAL_KHZ;
+  initial.order = LINEAR;
+  for (int i = 0; i < SWEEP_BUFFERS; i++) {
+    sweeps[i].plan.build(initial);
+    sweeps[i].values.resize(sweeps[i].plan.length);
+    sweeps[i].updated.resize(sweeps[i].plan.length);
+    sweeps[i].maxHold.resize(sweeps[i].plan.length);
+    sweeps[i].minHold.resize(sweeps[i].plan.length);
+    sweeps[i].average.resize(sweeps[i].plan.length);
+    for (int j = 0; j < sweeps[i].plan.length; j++) {
+      sweeps[i].values.set(j, 0);
+      sweeps[i].updated.set(j, 0);
+      sweeps[i].maxHold.set(j, 0);
+      sweeps[i].minHold.set(j, 0);
+      sweeps[i].average.set(j, 0);
+    }
+    sweeps[i].generation = 0;
+    sweeps[i].timestamp = 0;
+    sweeps[i].complete = false;
+    sweepBorrows[i] = 0;
+  }
 
   // Create mutexes
-  scanMutex = xSemaphoreCreateMutex();
   lowbandMutex = xSemaphoreCreateMutex();
+  statsMutex = xSemaphoreCreateMutex();
+  finderMutex = xSemaphoreCreateMutex();
+  stepSemaphore = xSemaphoreCreateBinary();
+  resetStats();
 
-  // Reset receiver
-  reset();
+  // Mailbox for latest config
+  configQueue = xQueueCreate(1, sizeof(ScanConfig));
 }
 
-// Start background scanning
-void RX5808::startScan() {
-  // Start scanning task only if not already running
-  if (scanHandle == NULL) {
-    xTaskCreate(_scan, "scan", SCAN_STACK_SIZE, this, 1, &scanHandle);
+// Begin receiver
+// Can't call in constructor as some transports need scheduler running
+void RX5808::begin() {
+  for (int i = 0; i < modules; i++) {
+    // Setup rssi pin
+    pinMode(rssiPins[i], INPUT);
+
+    // Setup register transport pins, leaving module unprogrammed if bus failed
+    if (!transports[i]->begin()) {
+      log_e("RX5808 module %d transport failed to start", i + 1);
+      continue;
+    }
+
+    // Reset receiver
+    reset(i);
   }
+
+  // Timer callback runs in high priority esp_timer task so isn't delayed by web server or display
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = _stepTimer;
+  timerArgs.arg = this;
+  timerArgs.dispatch_method = ESP_TIMER_TASK;
+  timerArgs.name = "scan step";
+  esp_timer_create(&timerArgs, &stepTimer);
+
+  // Create scanning task paused, with initial config waiting for it
+  reconfigure();
+  xTaskCreate(_scan, "scan", SCAN_STACK_SIZE, this, 1, &scanHandle);
+}
+
+// Resume background scanning
+// Cheap to call repeatedly, only wakes scanning task if paused
+void RX5808::startScan() {
+  if (!running.exchange(true)) xTaskNotifyGive(scanHandle);
 }
 
-// Stop background scanning
+// Pause background scanning
+// Takes effect at next step, after current frequency is read
 void RX5808::stopScan() {
-  // Cancel scanning task only if already running
-  if (scanHandle != NULL) {
-    stopRequested = true;
+  running.store(false);
+}
+
+// Send current settings and band to scanning task
+// Applied from next step, restarting any sweep in progress
+void RX5808::reconfigure() {
+  ScanConfig config;
+  int index = settings->scanIntervalIndex.get();
+  int focus = focusFrequency.get();
+  int finder = finderFrequency.get();
+  config.intervalKhz = settings->scanIntervalKhz.get();
+  config.lowband = lowband.get();
+  if (finder != 0) {
+    // Finder overrides all sweeping until turned off
+    config.mode = TRACK;
+    config.minFrequency = finder;
+    config.maxFrequency = finder;
+    config.intervalKhz = FOCUS_INTERVAL_KHZ;
+  } else if (focus != 0) {
+    // Focus overrides scan interval until turned off
+    config.mode = FOCUS;
+    config.minFrequency = focusMinFrequency(focus);
+    config.maxFrequency = config.minFrequency + 2 * FOCUS_HALF_WIDTH;
+    config.intervalKhz = FOCUS_INTERVAL_KHZ;
+  } else if (index == CHANNEL_TABLE_INDEX) {
+    config.mode = CHANNELS;
+    config.minFrequency = 0;
+    config.maxFrequency = 0;
+  } else if (index == CUSTOM_RANGE_INDEX) {
+    config.mode = RANGE;
+    config.minFrequency = settings->rangeStart.get();
+    config.maxFrequency = settings->rangeStop.get();
+  } else {
+    config.mode = BAND;
+    config.minFrequency = config.lowband ? LOWBAND_MIN_FREQUENCY : HIGHBAND_MIN_FREQUENCY;
+    config.maxFrequency = config.minFrequency + SCAN_FREQUENCY_RANGE;
+  }
+  config.order = (SweepOrder)settings->sweepOrderIndex.get();
+
+  // Use auto-tuned dwell and samples if available
+  int tunedSettleTime = settings->tunedSettleTime.get();
+  int tunedSamples = settings->tunedSamples.get();
+  config.maxSettleTime = tunedSettleTime != DEFAULT_TUNED ? tunedSettleTime : RSSI_STABILISATION_TIME * 1000UL;
+  config.samples = tunedSamples != DEFAULT_TUNED ? tunedSamples : RSSI_SAMPLES;
+
+  // Replace any config not yet picked up
+  xQueueOverwrite(configQueue, &config);
+}
+
+// Ask scanning task to measure best settle time and samples
+// Runs even if scanning paused, autoTuning cleared once finished
+void RX5808::requestAutoTune() {
+  autoTuning.set(true);
+  autoTuneRequested.store(true);
+  xTaskNotifyGive(scanHandle);
+}
+
+// Restart max-hold, min-hold and average traces from latest readings
+// Scanning task resets them before its next step
+void RX5808::resetTraces() {
+  traceResetRequested.store(true);
+}
+
+// Number of modules scanning together
+int RX5808::getModules() {
+  return modules;
+}
+
+// Transmitters currently tracked across complete sweeps
+PeakList RX5808::getPeaks() {
+  return peakDetector.getPeaks();
+}
+
+// Copy complete sweeps published between from and to in ms, see SweepHistory::copy()
+int RX5808::getHistory(unsigned long from, unsigned long to, HistoryRecord *records, int maxRecords, uint8_t *values, int maxBytes, ScanPlan &plan, bool &more) {
+  return history.copy(from, to, records, maxRecords, values, maxBytes, plan, more);
+}
+
+// Copy most recent complete sweeps downsampled for display, see SweepHistory::copyWaterfall()
+int RX5808::getWaterfall(uint8_t *rows, int maxRows, int maxColumns, int &columns, ScanPlan &plan) {
+  return history.copyWaterfall(rows, maxRows, maxColumns, columns, plan);
+}
+
+// Copy most recent finder readings numbered after given reading, up to maxLength
+// Only includes readings at current finder frequency, first set to number of first reading copied
+// Returns number of readings copied
+int RX5808::getFinderTrace(uint16_t *trace, int maxLength, uint32_t after, uint32_t &first) {
+  xSemaphoreTake(finderMutex, portMAX_DELAY);
+  uint32_t count = finderCount;
+  int length = std::min(maxLength, FINDER_TRACE_LENGTH);
+  first = std::max({ after, finderStart, count > (uint32_t)length ? count - length : 0 });
+  for (uint32_t i = first; i < count; i++) {
+    trace[i - first] = finderTrace[i % FINDER_TRACE_LENGTH];
   }
+  xSemaphoreGive(finderMutex);
+  return count > first ? count - first : 0;
+}
+
+// Get copy of scan timing statistics
+ScanStats RX5808::getStats() {
+  xSemaphoreTake(statsMutex, portMAX_DELAY);
+  ScanStats copy = stats;
+  xSemaphoreGive(statsMutex);
+  copy.transport = transports[0]->name();
+  copy.stackFree = uxTaskGetStackHighWaterMark(scanHandle);
+  return copy;
+}
+
+// Ask scanning task to save current rssi as high/low calibration
+// Scanning task owns the receiver, so it takes the readings between steps, poll isCalibrating() for when it's done
+// Returns false without requesting if auto-tune or another calibration is running
+bool RX5808::requestCalibration(bool high) {
+  if (autoTuning.get()) return false;
+
+  int expected = NO_CALIBRATION;
+  if (!calibrationRequest.compare_exchange_strong(expected, high ? CALIBRATE_HIGH : CALIBRATE_LOW)) return false;
+
+  xTaskNotifyGive(scanHandle);
+  return true;
+}
+
+// Calibration requested and not yet saved
+bool RX5808::isCalibrating() {
+  return calibrationRequest.load() != NO_CALIBRATION;
 }
 
-// Save current rssi as high/low calibration
-void RX5808::calibrate(bool high) {
-  // Set to F4
-  setFrequency(5800);
+// Measure and save calibration, run by scanning task
+// Sweep is abandoned first, so receiver is free to retune
+void RX5808::runCalibration(bool high) {
+  // Set all modules to F4
+  for (int i = 0; i < modules; i++) {
+    setFrequency(5800, i);
+  }
 
   // Give time for rssi to stabilise
   delay(RSSI_STABILISATION_TIME);
 
-  // Save rssi
+  // Save rssi of first module
   if (high) {
     xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
     settings->highCalibratedRssi.set(readRSSI());
     xSemaphoreGive(settings->settingsMutex);
   } else {
     xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
-    settings->lowCalibratedRssi.set(readRSSI());
+    int rssi = readRSSI();
+    settings->lowCalibratedRssi.set(rssi);
+
+    // Offset other modules so their noise floor matches first module
+    for (int i = 1; i < modules; i++) {
+      settings->rssiOffsets[i].set(rssi - readRSSI(RSSI_SAMPLES, i));
+    }
     xSemaphoreGive(settings->settingsMutex);
   }
+
+  calibrationRequest.store(NO_CALIBRATION);
 }
 
 // Background task that runs scanning continuously
+// Never exits, sleeps while paused and picks up new config between steps
 void RX5808::_scan(void *parameter) {
   // Static cast weirdness to access parameters
   RX5808 *receiver = static_cast<RX5808 *>(parameter);
 
-  // Get interval at which to scan
-  xSemaphoreTake(receiver->settings->settingsMutex, portMAX_DELAY);
-  float interval = receiver->settings->scanInterval.get();
-  xSemaphoreGive(receiver->settings->settingsMutex);
+  // Wait for initial config from begin()
+  ScanConfig config;
+  xQueueReceive(receiver->configQueue, &config, portMAX_DELAY);
 
-  // Calculate number of values to scan
-  int numScannedValues = (SCAN_FREQUENCY_RANGE / interval) + 1;  // +1 for final number inclusion
+  while (true) {
+    receiver->waitWhilePaused();
 
-  // Loop continuously
-  // Stops when scanning task cancelled
-  while (!receiver->stopRequested) {
-    for (int i = 0; i < numScannedValues; i++) {
-      // Safely stop scanning when no mutexes taken
-      if (receiver->stopRequested) break;
+    // Calibrate on request even if paused, then resume previous config
+    int calibration = receiver->calibrationRequest.load();
+    if (calibration != NO_CALIBRATION) {
+      receiver->runCalibration(calibration == CALIBRATE_HIGH);
+      continue;
+    }
 
-      // Safely get lowband state
-      xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-      bool lowband = receiver->lowband.get();
-      xSemaphoreGive(receiver->lowbandMutex);
+    // Tune between sweeps, then carry on with new config
+    if (receiver->autoTuneRequested.load()) {
+      receiver->autoTune();
+      continue;
+    }
 
-      // Get minimum frequency to support changing to lowband
-      int min_freq = lowband ? LOWBAND_MIN_FREQUENCY : HIGHBAND_MIN_FREQUENCY;
+    // Pick up any config sent while paused, timings no longer comparable
+    if (xQueueReceive(receiver->configQueue, &config, 0) == pdTRUE) receiver->resetStats();
 
-      // Set frequency and offset by minimum
-      receiver->setFrequency((int)round(i * interval + min_freq));
+    // Sample single frequency until paused or reconfigured
+    if (config.mode == TRACK) {
+      receiver->track(config);
+      continue;
+    }
 
-      // Give time for rssi to stabilise
-      vTaskDelay(pdMS_TO_TICKS(RSSI_STABILISATION_TIME));
+    // Only recalculate frequencies when interval, band or order changed
+    if (!receiver->plan.matches(config)) {
+      receiver->plan.build(config);
+      receiver->plan.buildOrder(receiver->order);
+      receiver->peakDetector.setPlan(receiver->plan);
+    }
 
-      // Safely stop scanning when no mutexes taken
-      // Second call in case task cancelled during delay
-      if (receiver->stopRequested) break;
+    // Get buffer not being read to write sweep into
+    Sweep *sweep = receiver->beginSweep(receiver->plan);
+    bool completed = true;
+
+    // Find which frequencies to revisit from previous sweep
+    if (config.order == PRIORITY) receiver->updateNoiseFloor(sweep);
+
+    // Each module takes the next step in order, so partial sweeps stay evenly spread
+    for (int step = 0; step < sweep->plan.length; step += receiver->modules) {
+      int count = std::min(receiver->modules, sweep->plan.length - step);
+      if (!receiver->measure(sweep, &receiver->order[step], count, config)) {
+        completed = false;
+        break;
+      }
+
+      // Revisit a frequency with activity between every background step
+      // Every frequency is still scanned at least once every two sweep lengths
+      if (config.order == PRIORITY) {
+        int activeIndex = receiver->nextActiveIndex(sweep->plan.length);
+        uint16_t revisit = activeIndex;
+        if (activeIndex >= 0 && !receiver->measure(sweep, &revisit, 1, config)) {
+          completed = false;
+          break;
+        }
+      }
+
+      // Publish partial sweep once scanned frequencies are evenly spread across band, or often for priority order
+      // Carry on in another buffer so published one stays unchanged
+      bool publish = false;
+      for (int done = step + 1; done <= step + count; done++) {
+        publish |= sweep->plan.publishAfter(done);
+      }
+      if (publish) {
+        sweep->complete = false;
+        receiver->publishSweep(sweep);
+        sweep = receiver->beginSweep(receiver->plan);
+      }
+    }
 
-      // Take mutex to safely modify data in this task
-      xSemaphoreTake(receiver->scanMutex, portMAX_DELAY);
-      receiver->rssiValues.set(i, receiver->readRSSI());
-      xSemaphoreGive(receiver->scanMutex);
+    // Abandoned sweeps are never made visible to readers
+    if (completed) {
+      sweep->complete = true;
+      receiver->publishSweep(sweep);
+
+      // Scanning task only writes unpublished buffers, so sweep stays unchanged until next is published
+      receiver->peakDetector.update(sweep->plan, sweep->values, sweep->generation, sweep->timestamp);
+      receiver->history.add(sweep->plan, sweep->values, sweep->generation, sweep->timestamp);
+
+      // Time between back to back complete sweeps
+      int64_t now = esp_timer_get_time();
+      if (receiver->lastSweepTime != 0) receiver->recordSweep(now - receiver->lastSweepTime);
+      receiver->lastSweepTime = now;
+    } else {
+      // Period would include pause or be for old config
+      receiver->lastSweepTime = 0;
     }
   }
+}
 
-  // Task closed
-  receiver->scanHandle = NULL;
-  receiver->stopRequested = false;
-  vTaskDelete(NULL);
+// Wake scanning task when step deadline reached
+void RX5808::_stepTimer(void *parameter) {
+  RX5808 *receiver = static_cast<RX5808 *>(parameter);
+  xSemaphoreGive(receiver->stepSemaphore);
 }
 
-// Set receiver frequency
-void RX5808::setFrequency(int frequency) {
-  // Calculate frequency value to send to receiver
-  unsigned long toSend = frequencyToRegister(frequency);
+// Sleep until given esp_timer time in us
+// Returns how late task woke in us
+int64_t RX5808::waitUntil(int64_t deadline) {
+  int64_t remaining = deadline - esp_timer_get_time();
+  if (remaining > 0) {
+    esp_timer_start_once(stepTimer, remaining);
+    xSemaphoreTake(stepSemaphore, portMAX_DELAY);
+  }
+  return esp_timer_get_time() - deadline;
+}
 
-  // Send data to 0x1 register
-  sendRegister(0x01, toSend);
+// Record lateness of a scan step
+void RX5808::recordStep(int64_t jitter) {
+  xSemaphoreTake(statsMutex, portMAX_DELAY);
+  stats.steps++;
+  stats.totalJitter += jitter;
+  stats.maxJitter = std::max(stats.maxJitter, jitter);
+  xSemaphoreGive(statsMutex);
 }
 
-// Read rssi from receiver
-int RX5808::readRSSI() {
-  // Record multiple rssi values and average
-  int rssi = 0;
-  for (int i = 0; i < RSSI_SAMPLES; i++) {
-    rssi += analogRead(rssiPin);
+// Record time taken to send a retune to a module
+void RX5808::recordRetune(int64_t time) {
+  xSemaphoreTake(statsMutex, portMAX_DELAY);
+  stats.retunes++;
+  stats.totalRetuneTime += time;
+  stats.maxRetuneTime = std::max(stats.maxRetuneTime, time);
+  xSemaphoreGive(statsMutex);
+}
+
+// Record time taken by a complete sweep
+void RX5808::recordSweep(int64_t period) {
+  xSemaphoreTake(statsMutex, portMAX_DELAY);
+  stats.sweeps++;
+  stats.lastSweepPeriod = period;
+  stats.minSweepPeriod = stats.sweeps == 1 ? period : std::min(stats.minSweepPeriod, period);
+  stats.maxSweepPeriod = std::max(stats.maxSweepPeriod, period);
+  stats.totalSweepPeriod += period;
+  xSemaphoreGive(statsMutex);
+}
+
+// Clear scan timing statistics
+void RX5808::resetStats() {
+  xSemaphoreTake(statsMutex, portMAX_DELAY);
+  stats = {};
+  xSemaphoreGive(statsMutex);
+  lastSweepTime = 0;
+}
+
+// Sleep without using cpu until startScan(), requestAutoTune() or requestCalibration() called
+void RX5808::waitWhilePaused() {
+  while (!running.load() && !autoTuneRequested.load() && calibrationRequest.load() == NO_CALIBRATION) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
   }
-  rssi /= RSSI_SAMPLES;
+}
 
-  return rssi;
+// Check between steps whether sweep can carry on
+// Abandons sweep if paused, new config received or calibration requested, updating config
+bool RX5808::continueSweep(ScanConfig &config) {
+  if (!running.load() || autoTuneRequested.load() || calibrationRequest.load() != NO_CALIBRATION) return false;
+  if (xQueueReceive(configQueue, &config, 0) == pdTRUE) {
+    resetStats();
+    return false;
+  }
+  return true;
 }
 
-// Reset receiver
-void RX5808::reset() {
-  sendRegister(0x0F, 0b00000000000000000000);
+// Sample finder frequency at a fixed rate into trace
+// Returns when paused or reconfigured, updating config
+void RX5808::track(ScanConfig &config) {
+  setFrequency(config.minFrequency);
+
+  // Readings from previous frequency aren't part of this trace
+  xSemaphoreTake(finderMutex, portMAX_DELAY);
+  finderStart = finderCount;
+  xSemaphoreGive(finderMutex);
+
+  int samples = std::min(config.samples, FINDER_MAX_SAMPLES);
+  int64_t deadline = esp_timer_get_time() + config.maxSettleTime;
+
+  while (continueSweep(config)) {
+    int64_t jitter = waitUntil(deadline);
+    recordStep(jitter);
+
+    int rssi = readRSSI(samples);
+    finderRssi.set(rssi);
+
+    xSemaphoreTake(finderMutex, portMAX_DELAY);
+    finderTrace[finderCount % FINDER_TRACE_LENGTH] = rssi;
+    finderCount++;
+    xSemaphoreGive(finderMutex);
+
+    // Skip missed samples rather than catching up in a burst
+    deadline += FINDER_SAMPLE_INTERVAL;
+    if (jitter > FINDER_SAMPLE_INTERVAL) deadline = esp_timer_get_time() + FINDER_SAMPLE_INTERVAL;
+  }
+}
+
+// Find smallest settle time and samples that give target rssi variance
+// Step across tunable range, measuring adc noise and how long rssi takes to settle after a worst case retune
+void RX5808::autoTune() {
+  autoTuneRequested.store(false);
+
+  int64_t maxVariance = 0;
+  int maxSettleTime = 0;
+
+  for (int i = 0; i < AUTO_TUNE_FREQUENCIES; i++) {
+    int frequency = RX5808_MIN_FREQUENCY + i * (RX5808_MAX_FREQUENCY - RX5808_MIN_FREQUENCY) / (AUTO_TUNE_FREQUENCIES - 1);
+
+    // Noise of single sample once fully settled
+    setFrequency(frequency);
+    waitUntil(esp_timer_get_time() + RSSI_STABILISATION_TIME * 1000);
+    int64_t variance = measureVariance(1);
+    maxVariance = std::max(maxVariance, variance);
+
+    maxSettleTime = std::max(maxSettleTime, measureSettleTime(frequency, variance));
+  }
+
+  // Add margin to slowest settle time, never more than untuned time
+  int settle = std::clamp(maxSettleTime * (100 + AUTO_TUNE_SETTLE_MARGIN) / 100, AUTO_TUNE_MIN_SETTLE_TIME, RSSI_STABILISATION_TIME * 1000);
+
+  // Averaging n samples divides variance by n
+  int samples = std::clamp((int)((maxVariance + AUTO_TUNE_TARGET_VARIANCE - 1) / AUTO_TUNE_TARGET_VARIANCE), 1, AUTO_TUNE_MAX_SAMPLES);
+
+  // Samples aren't fully independent, so check and increase until target met
+  while (samples < AUTO_TUNE_MAX_SAMPLES && measureVariance(samples) > AUTO_TUNE_TARGET_VARIANCE) {
+    samples = std::min(samples * 2, AUTO_TUNE_MAX_SAMPLES);
+  }
+
+  // Save results
+  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+  settings->tunedSettleTime.set(settle);
+  settings->tunedSamples.set(samples);
+  xSemaphoreGive(settings->settingsMutex);
+
+  autoTuning.set(false);
+
+  // Scan with new results
+  reconfigure();
+}
+
+// Variance of rssi readings averaged from given samples, at current frequency
+// Integer maths as no fpu
+int64_t RX5808::measureVariance(int samples) {
+  int64_t sum = 0;
+  int64_t sumSquares = 0;
+  for (int i = 0; i < AUTO_TUNE_NOISE_READINGS; i++) {
+    int rssi = readRSSI(samples);
+    sum += rssi;
+    sumSquares += (int64_t)rssi * rssi;
+  }
+  return (AUTO_TUNE_NOISE_READINGS * sumSquares - sum * sum) / ((int64_t)AUTO_TUNE_NOISE_READINGS * AUTO_TUNE_NOISE_READINGS);
+}
+
+// Time in us for rssi to settle at frequency after retuning from far end of range
+// Settled once every later reading is within tolerance or noise of final reading
+int RX5808::measureSettleTime(int frequency, int64_t variance) {
+  // Retune from furthest frequency, largest jump is slowest to settle
+  int far = frequency - RX5808_MIN_FREQUENCY < RX5808_MAX_FREQUENCY - frequency ? RX5808_MAX_FREQUENCY : RX5808_MIN_FREQUENCY;
+  setFrequency(far);
+  waitUntil(esp_timer_get_time() + RSSI_STABILISATION_TIME * 1000);
+
+  // Record readings at same interval as adaptive settle
+  setFrequency(frequency);
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < AUTO_TUNE_CURVE_LENGTH; i++) {
+    waitUntil(start + (int64_t)(i + 1) * RSSI_SETTLE_SAMPLE_INTERVAL);
+    settleCurve[i] = readRSSI(RSSI_SETTLE_SAMPLES);
+  }
+
+  // Compare squared to avoid sqrt, allowing three standard deviations of averaged reading
+  int64_t toleranceSquared = std::max((int64_t)RSSI_SETTLE_TOLERANCE * RSSI_SETTLE_TOLERANCE, 9 * variance / RSSI_SETTLE_SAMPLES);
+
+  // Find last reading outside tolerance of final one
+  int finalRssi = settleCurve[AUTO_TUNE_CURVE_LENGTH - 1];
+  int settled = 0;
+  for (int i = 0; i < AUTO_TUNE_CURVE_LENGTH; i++) {
+    int64_t difference = settleCurve[i] - finalRssi;
+    if (difference * difference > toleranceSquared) settled = i + 1;
+  }
+
+  return (settled + 1) * RSSI_SETTLE_SAMPLE_INTERVAL;
+}
+
+// Get buffer to write next sweep into
+// Buffer is never the published sweep, nor one still borrowed by a reader
+// Starts with values of published sweep if same frequencies, so partial sweeps only update what was scanned
+Sweep *RX5808::beginSweep(const ScanPlan &plan) {
+  while (true) {
+    for (int i = 0; i < SWEEP_BUFFERS; i++) {
+      if (i != publishedSweep.load() && sweepBorrows[i].load() == 0) {
+        Sweep *sweep = &sweeps[i];
+        sweep->plan = plan;
+        sweep->values.resize(plan.length);
+        sweep->updated.resize(plan.length);
+        sweep->maxHold.resize(plan.length);
+        sweep->minHold.resize(plan.length);
+        sweep->average.resize(plan.length);
+
+        // Only this task writes buffers, so published one is safe to read
+        // Traces carry on from published sweep, and restart from first reading if frequencies changed
+        const Sweep *published = &sweeps[publishedSweep.load()];
+        bool sameFrequencies = published->plan.sameFrequencies(plan);
+        for (int j = 0; j < plan.length; j++) {
+          sweep->values.set(j, sameFrequencies ? published->values.get(j) : 0);
+          sweep->updated.set(j, sameFrequencies ? published->updated.get(j) : 0);
+          sweep->maxHold.set(j, sameFrequencies ? published->maxHold.get(j) : 0);
+          sweep->minHold.set(j, sameFrequencies ? published->minHold.get(j) : 0);
+          sweep->average.set(j, sameFrequencies ? published->average.get(j) : 0);
+        }
+
+        return sweep;
+      }
+    }
+
+    // Every buffer in use, wait for a reader to return one
+    vTaskDelay(1);
+  }
+}
+
+// Make completed sweep the one returned to readers
+void RX5808::publishSweep(Sweep *sweep) {
+  sweep->generation = sweeps[publishedSweep.load()].generation + 1;
+  sweep->timestamp = millis();
+  publishedSweep.store(sweep - sweeps);
+}
+
+// Scan one frequency per module into sweep, count must not be more than modules
+// Returns false if sweep should be abandoned
+bool RX5808::measure(Sweep *sweep, const uint16_t *indices, int count, ScanConfig &config) {
+  if (!continueSweep(config)) return false;
+
+  // Restart traces from latest readings, unscanned frequencies restart from their first reading
+  if (traceResetRequested.exchange(false)) {
+    for (int i = 0; i < sweep->plan.length; i++) {
+      sweep->maxHold.set(i, sweep->values.get(i));
+      sweep->minHold.set(i, sweep->values.get(i));
+      sweep->average.set(i, sweep->values.get(i) << TRACE_AVERAGE_FRACTION);
+    }
+  }
+
+  // Set frequencies using precalculated register words
+  // Every module is tuned before waiting, so each settles while the others are tuned and checked
+  for (int i = 0; i < count; i++) {
+    setRegister(sweep->plan.registerWord(indices[i]), i);
+  }
+
+  // Give time for rssi to stabilise, later modules have already had time while earlier ones settled
+  int64_t start = esp_timer_get_time();
+  unsigned long settled = 0;
+  for (int i = 0; i < count; i++) {
+    settled = waitForRssiSettle(config.maxSettleTime, start, i);
+  }
+
+  // Second check in case paused or reconfigured during delay
+  if (!continueSweep(config)) return false;
+
+  // Sweep isn't visible to readers until published so no mutex needed
+  for (int i = 0; i < count; i++) {
+    int index = indices[i];
+    int rssi = std::clamp(readRSSI(config.samples, i) + settings->rssiOffsets[i].get(), 0, 4095);
+    updateTraces(sweep, index, rssi);
+    sweep->values.set(index, rssi);
+    sweep->updated.set(index, millis());
+
+    // Keep revisiting frequency while it has activity
+    active[index] = rssi > noiseFloor + PRIORITY_ACTIVITY_THRESHOLD;
+  }
+  settleTime.set(settled);
+
+  return true;
+}
+
+// Fold new reading into traces, must be called before updated is set
+void RX5808::updateTraces(Sweep *sweep, int index, int rssi) {
+  // First reading since frequencies changed starts every trace
+  if (sweep->updated.get(index) == 0) {
+    sweep->maxHold.set(index, rssi);
+    sweep->minHold.set(index, rssi);
+    sweep->average.set(index, rssi << TRACE_AVERAGE_FRACTION);
+    return;
+  }
+
+  sweep->maxHold.set(index, std::max((int)sweep->maxHold.get(index), rssi));
+  sweep->minHold.set(index, std::min((int)sweep->minHold.get(index), rssi));
+
+  int average = sweep->average.get(index);
+  sweep->average.set(index, average + (((rssi << TRACE_AVERAGE_FRACTION) - average) >> TRACE_AVERAGE_SHIFT));
+}
+
+// Estimate noise floor as median rssi, and mark frequencies above it as active
+// Most of band is empty, so median is unaffected by a few strong signals
+void RX5808::updateNoiseFloor(const Sweep *sweep) {
+  int length = sweep->plan.length;
+  for (int i = 0; i < length; i++) {
+    sortedRssi[i] = sweep->values.get(i);
+  }
+  std::nth_element(sortedRssi, sortedRssi + length / 2, sortedRssi + length);
+  noiseFloor = sortedRssi[length / 2];
+
+  for (int i = 0; i < length; i++) {
+    active[i] = sweep->values.get(i) > noiseFloor + PRIORITY_ACTIVITY_THRESHOLD;
+  }
+}
+
+// Get next active frequency to revisit, taking turns between them
+// Returns -1 if none active
+int RX5808::nextActiveIndex(int length) {
+  for (int i = 0; i < length; i++) {
+    activeCursor = (activeCursor + 1) % length;
+    if (active[activeCursor]) return activeCursor;
+  }
+  return -1;
+}
+
+// Borrow most recently published sweep without locking
+// Sweep won't change until given back with returnSweep()
+const Sweep *RX5808::borrowSweep() {
+  while (true) {
+    int index = publishedSweep.load();
+    sweepBorrows[index]++;
+
+    // Scanning task only writes to unpublished buffers without borrows
+    // If still published after borrowing, it's complete and now can't be written to
+    if (publishedSweep.load() == index) return &sweeps[index];
+
+    sweepBorrows[index]--;
+  }
+}
+
+// Give back sweep taken with borrowSweep()
+void RX5808::returnSweep(const Sweep *sweep) {
+  sweepBorrows[sweep - sweeps]--;
+}
+
+// Set module frequency
+void RX5808::setFrequency(int frequency, int module) {
+  setRegister(frequencyToRegister(frequency), module);
 }
 
-// Send data to specified receiver register
-void RX5808::sendRegister(byte address, unsigned long data) {
-  // Begin transmission
-  digitalWrite(lePin, LOW);
+// Set module frequency from precalculated register word
+// Timed so transports can be compared, spi only counts time to queue frame
+void RX5808::setRegister(uint16_t word, int module) {
+  int64_t start = esp_timer_get_time();
 
-  // Send address (LSB)
-  for (int i = 0; i < 4; i++) {
-    sendBit(bitRead(address, i));
+  // Send data to 0x1 register
+  transports[module]->sendRegister(0x01, word);
+
+  recordRetune(esp_timer_get_time() - start);
+}
+
+// Wait for rssi to stabilise after retuning
+// Paced by esp_timer deadlines relative to retune, recording how late the step woke
+// Returns time since start in us
+unsigned long RX5808::waitForRssiSettle(unsigned long maxSettleTime, int64_t start, int module) {
+  int64_t end = start + maxSettleTime;
+  int64_t jitter = 0;
+
+#ifdef ADAPTIVE_RSSI_SETTLE
+  // Sample until consecutive readings agree, bounded by max settle time
+  int previous = readRSSI(RSSI_SETTLE_SAMPLES, module);
+  int stableReadings = 0;
+  int64_t deadline = std::max(start, esp_timer_get_time());
+  while (deadline < end) {
+    deadline = std::min(deadline + RSSI_SETTLE_SAMPLE_INTERVAL, end);
+    jitter = std::max(jitter, waitUntil(deadline));
+
+    int current = readRSSI(RSSI_SETTLE_SAMPLES, module);
+    if (abs(current - previous) <= RSSI_SETTLE_TOLERANCE) {
+      if (++stableReadings >= RSSI_SETTLE_STABLE_READINGS) break;
+    } else {
+      stableReadings = 0;
+    }
+    previous = current;
   }
+#else
+  jitter = waitUntil(end);
+#endif
 
-  // Set to write mode
-  sendBit(1);
+  recordStep(jitter);
+
+  return esp_timer_get_time() - start;
+}
+
+// Read rssi from receiver
+int RX5808::readRSSI(int samples, int module) {
+#ifdef CONTINUOUS_RSSI_ADC
+  // Fall back to oneshot reads if dma sampling unavailable
+  // Only one continuous adc channel can run, so only used with a single module
+  if (modules == 1) {
+    int dmaRssi = rssiAdc.read(samples);
+    if (dmaRssi >= 0) return dmaRssi;
+  }
+#endif
 
-  // Send data bits (LSB)
-  for (int i = 0; i < 20; i++) {
-    sendBit(bitRead(data, i));
+  // Record multiple rssi values and average
+  int rssi = 0;
+  for (int i = 0; i < samples; i++) {
+    rssi += analogRead(rssiPins[module]);
   }
+  rssi /= samples;
 
-  // End transmission
-  digitalWrite(lePin, HIGH);
+  return rssi;
 }
 
-// Send 0 or 1 to receiver
-void RX5808::sendBit(bool bit) {
-  // Set data value
-  digitalWrite(dataPin, bit);
+// Reset receiver
+void RX5808::reset(int module) {
+  transports[module]->sendRegister(0x0F, 0b00000000000000000000);
+}
 
-  // Pulse clock
-  digitalWrite(clkPin, HIGH);
-  delayMicroseconds(10);
-  digitalWrite(clkPin, LOW);
+// Reading of given trace at index
+uint16_t Sweep::trace(TraceMode mode, int index) const {
+  switch (mode) {
+    case MAX_HOLD: return maxHold.get(index);
+    case MIN_HOLD: return minHold.get(index);
+    case AVERAGE: return average.get(index) >> TRACE_AVERAGE_FRACTION;
+    default: return values.get(index);
+  }
 }
 
-// Convert frequency number to required binary representation
-unsigned long RX5808::frequencyToRegister(int frequency) {
-  // Calculate parts to send to receiver
-  frequency -= 479;
-  int n = frequency / 64;
-  int a = (frequency % 64) / 2;
+// Name of trace used by api and usb
+const char *traceName(TraceMode mode) {
+  switch (mode) {
+    case MAX_HOLD: return "max";
+    case MIN_HOLD: return "min";
+    case AVERAGE: return "average";
+    default: return "live";
+  }
+}
 
-  // Calculate frequency value to send to receiver
-  return (n << 7) | a;
+// Find trace from name used by api and usb
+// Returns false if name isn't a trace
+bool parseTrace(const char *name, TraceMode &mode) {
+  for (int i = LIVE; i <= AVERAGE; i++) {
+    if (strcmp(name, traceName((TraceMode)i)) == 0) {
+      mode = (TraceMode)i;
+      return true;
+    }
+  }
+  return false;
 }
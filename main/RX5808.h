@@ -2,51 +2,224 @@
 #define RX5808_H
 
 #include <Arduino.h>
+#include "esp_timer.h"
+#include "history.h"
+#include "peaks.h"
+#include "rssiadc.h"
+#include "scanplan.h"
 #include "settings.h"
+#include "transport.h"
 #include "variable.h"
 
-#define MAX_FREQUENCIES_SCANNED 120 + 1
-#define HIGHBAND_MIN_FREQUENCY 5645
-#define LOWBAND_MIN_FREQUENCY 5345
-#define SCAN_FREQUENCY_RANGE 300
+// Uncomment this line to sample rssi with continuous dma conversions instead of oneshot analogRead()
+// Frees the cpu while sampling and allows many more samples per step
+// #define CONTINUOUS_RSSI_ADC
 
 #define RSSI_STABILISATION_TIME 30
+#ifdef CONTINUOUS_RSSI_ADC
+#define RSSI_SAMPLES 128
+#define RSSI_REDUCTION TRIMMED_MEAN
+#else
 #define RSSI_SAMPLES 30
+#endif
+
+// Comment out this line to always wait the full RSSI_STABILISATION_TIME after each retune
+// When defined, rssi is sampled after retuning and scanning moves on once readings converge
+#define ADAPTIVE_RSSI_SETTLE
+
+#define RSSI_SETTLE_TOLERANCE 8        // Max difference between consecutive readings to be considered settled
+#define RSSI_SETTLE_STABLE_READINGS 2  // Consecutive in-tolerance readings required
+#define RSSI_SETTLE_SAMPLES 4          // Samples averaged into each settle reading
+#define RSSI_SETTLE_SAMPLE_INTERVAL 500  // Time between settle readings in us
+
+// Auto-tune measures settle time and adc noise across tunable range
+#define AUTO_TUNE_FREQUENCIES 8       // Frequencies tested, evenly spread from RX5808_MIN_FREQUENCY to RX5808_MAX_FREQUENCY
+#define AUTO_TUNE_NOISE_READINGS 32   // Readings used to measure variance
+#define AUTO_TUNE_TARGET_VARIANCE 16  // Target variance of averaged rssi reading
+#define AUTO_TUNE_SETTLE_MARGIN 25    // Percentage added to slowest measured settle time
+#define AUTO_TUNE_MIN_SETTLE_TIME 1000  // us
+#define AUTO_TUNE_MAX_SAMPLES 256
+#define AUTO_TUNE_CURVE_LENGTH (RSSI_STABILISATION_TIME * 1000 / RSSI_SETTLE_SAMPLE_INTERVAL)
+
+// Rssi above noise floor for frequency to be revisited more often in priority sweep order
+#define PRIORITY_ACTIVITY_THRESHOLD 200
+
+// Finder mode samples a single frequency continuously
+#define FINDER_SAMPLE_INTERVAL 2500  // Time between samples in us, 400Hz
+#define FINDER_MAX_SAMPLES 16        // Cap on rssi samples averaged per reading so sample rate is kept
+#define FINDER_TRACE_LENGTH 512      // Most recent readings kept for display and streaming
+
+// Bytes, sized for calibration and auto-tune saving settings to nvs from scanning task
+// Least free stack since boot is reported as stack_free in stats, keep it above a few hundred bytes
+#define SCAN_STACK_SIZE 4096
+
+// Traces kept for every frequency alongside latest reading, index matches trace setting
+enum TraceMode {
+  LIVE,      // Latest reading
+  MAX_HOLD,  // Strongest reading since traces reset
+  MIN_HOLD,  // Weakest reading since traces reset
+  AVERAGE    // Exponential average of readings
+};
+
+#define TRACE_AVERAGE_SHIFT 3     // Average moves 1/8 of the way to each new reading
+#define TRACE_AVERAGE_FRACTION 4  // Fractional bits kept in average so small changes aren't lost
+
+// Calibration waiting for or being run by scanning task
+enum CalibrationRequest {
+  NO_CALIBRATION,
+  CALIBRATE_LOW,
+  CALIBRATE_HIGH
+};
+
+// Published sweep, being written, and one borrowed by each reading task (loop and web server)
+#define SWEEP_BUFFERS 4
+
+// Timing of scan steps and sweeps since last reconfigure, all times in us
+// Jitter is how late the scanning task woke after a step's timer deadline
+struct ScanStats {
+  uint32_t steps;
+  int64_t totalJitter;
+  int64_t maxJitter;
+  uint32_t sweeps;  // Complete sweeps with a measured period
+  int64_t lastSweepPeriod;
+  int64_t minSweepPeriod;
+  int64_t maxSweepPeriod;
+  int64_t totalSweepPeriod;
+  uint32_t retunes;  // Register writes to change frequency
+  int64_t totalRetuneTime;  // Time sendRegister() held the cpu, compares transports
+  int64_t maxRetuneTime;
+  const char *transport;  // Name of first module's transport
+  uint32_t stackFree;  // Least free scanning task stack since boot in bytes, not reset with other stats
+};
+
+// Complete sweep of rssi values published by scanning task
+// Published sweeps are never modified while borrowed
+struct Sweep {
+  VariableBufferRestricted<uint16_t> values;   // Sized to plan, adc readings fit in 12 bits
+  VariableBufferRestricted<uint32_t> updated;  // Time each value scanned in ms, 0 if never
+  VariableBufferRestricted<uint16_t> maxHold;
+  VariableBufferRestricted<uint16_t> minHold;
+  VariableBufferRestricted<uint16_t> average;  // Has TRACE_AVERAGE_FRACTION fractional bits
+  ScanPlan plan;            // Frequencies values scanned at
+  uint32_t generation;      // Increases by one with every published sweep, 0 before first
+  unsigned long timestamp;  // Time sweep published in ms
+  bool complete;            // False if published part way through, unscanned values kept from previous sweep
 
-#define SCAN_STACK_SIZE 2048
+  uint16_t trace(TraceMode mode, int index) const;
+};
 
-// RX5808 receiver module
+// One or more RX5808 receiver modules scanning together
+// Each step of a sweep is split across modules, which are all tuned before waiting so they settle in parallel
 class RX5808 {
 public:
-  RX5808(uint8_t data, uint8_t le, uint8_t clk, uint8_t rssi, Settings *s);
+  RX5808(RegisterTransport **t, const uint8_t *rssi, int m, Settings *s);
+  void begin();
   void startScan();
   void stopScan();
-  void calibrate(bool high);
+  void reconfigure();
+  void requestAutoTune();
+  ScanStats getStats();
+  int getModules();
+  int getFinderTrace(uint16_t *trace, int maxLength, uint32_t after, uint32_t &first);
+  PeakList getPeaks();
+  int getHistory(unsigned long from, unsigned long to, HistoryRecord *records, int maxRecords, uint8_t *values, int maxBytes, ScanPlan &plan, bool &more);
+  int getWaterfall(uint8_t *rows, int maxRows, int maxColumns, int &columns, ScanPlan &plan);
+  bool requestCalibration(bool high);
+  bool isCalibrating();
+  void resetTraces();
+  const Sweep *borrowSweep();
+  void returnSweep(const Sweep *sweep);
 
-  VariableArrayRestricted<int, MAX_FREQUENCIES_SCANNED> rssiValues;
-  Variable<bool> lowband;
+  AtomicVariable<bool> lowband;  // Take lowbandMutex when toggling, then call reconfigure()
+  AtomicVariable<int> focusFrequency;  // Centre of focus window in MHz, 0 for full sweep, take lowbandMutex when changing, then call reconfigure()
+  AtomicVariable<int> finderFrequency;  // Frequency sampled continuously in MHz, 0 to sweep, take lowbandMutex when changing, then call reconfigure()
+  AtomicVariableRestricted<int> finderRssi;  // Latest finder reading
+  AtomicVariableRestricted<bool> autoTuning;  // Auto-tune requested or running
+  AtomicVariableRestricted<unsigned long> settleTime;  // Time waited for rssi to settle on last step in us
 
-  SemaphoreHandle_t scanMutex;
   SemaphoreHandle_t lowbandMutex;
 
 private:
   static void _scan(void *parameter);
-  void setFrequency(int frequency);
-  int readRSSI();
-  void reset();
-  void sendRegister(byte address, unsigned long data);
-  void sendBit(bool bit);
-  unsigned long frequencyToRegister(int frequency);
-
-  uint8_t dataPin;
-  uint8_t lePin;
-  uint8_t clkPin;
-  uint8_t rssiPin;
+  static void _stepTimer(void *parameter);
+  int64_t waitUntil(int64_t deadline);
+  void recordStep(int64_t jitter);
+  void recordRetune(int64_t time);
+  void recordSweep(int64_t period);
+  void resetStats();
+  Sweep *beginSweep(const ScanPlan &plan);
+  void publishSweep(Sweep *sweep);
+  void waitWhilePaused();
+  void runCalibration(bool high);
+  void autoTune();
+  int64_t measureVariance(int samples);
+  int measureSettleTime(int frequency, int64_t variance);
+  bool continueSweep(ScanConfig &config);
+  void track(ScanConfig &config);
+  bool measure(Sweep *sweep, const uint16_t *indices, int count, ScanConfig &config);
+  void updateTraces(Sweep *sweep, int index, int rssi);
+  void updateNoiseFloor(const Sweep *sweep);
+  int nextActiveIndex(int length);
+  void setFrequency(int frequency, int module = 0);
+  void setRegister(uint16_t word, int module = 0);
+  unsigned long waitForRssiSettle(unsigned long maxSettleTime, int64_t start, int module = 0);
+  int readRSSI(int samples = RSSI_SAMPLES, int module = 0);
+  void reset(int module);
+
+  // Modules share clock and data lines, with separate le and rssi pins
+  RegisterTransport *transports[MAX_RX5808_MODULES];
+  uint8_t rssiPins[MAX_RX5808_MODULES];
+  int modules;
+
+#ifdef CONTINUOUS_RSSI_ADC
+  RssiAdc rssiAdc;
+#endif
+
+  // Only used by scanning task
+  ScanPlan plan;
+  uint16_t order[MAX_FREQUENCIES_SCANNED];  // Index of frequency scanned at each step of plan
+  bool active[MAX_FREQUENCIES_SCANNED];  // Frequencies above noise floor, revisited in priority order
+  int sortedRssi[MAX_FREQUENCIES_SCANNED];  // Scratch space for median, too big for task stack
+  int settleCurve[AUTO_TUNE_CURVE_LENGTH];  // Scratch space for auto-tune
+  int noiseFloor;
+  int activeCursor;
 
+  Sweep sweeps[SWEEP_BUFFERS];
+  std::atomic<int> sweepBorrows[SWEEP_BUFFERS];
+  std::atomic<int> publishedSweep;
+
+  // Scanning task runs for lifetime of receiver, paused rather than deleted
   TaskHandle_t scanHandle;
-  volatile bool stopRequested;
+  QueueHandle_t configQueue;  // Holds only latest config, overwritten by reconfigure()
+  std::atomic<bool> running;
+  std::atomic<bool> autoTuneRequested;
+  std::atomic<int> calibrationRequest;  // CalibrationRequest, cleared by scanning task once calibration saved
+  std::atomic<bool> traceResetRequested;
+
+  // Wakes scanning task at step deadlines, more precise than FreeRTOS tick
+  esp_timer_handle_t stepTimer;
+  SemaphoreHandle_t stepSemaphore;
+
+  // Ring buffer of finder readings, numbered by finderCount
+  uint16_t finderTrace[FINDER_TRACE_LENGTH];
+  uint32_t finderCount;  // Total readings taken
+  uint32_t finderStart;  // Number of first reading at current finder frequency
+  SemaphoreHandle_t finderMutex;
+
+  // Transmitters found in complete sweeps
+  PeakDetector peakDetector;
+
+  // Recent complete sweeps quantised to 8 bits
+  SweepHistory history;
+
+  ScanStats stats;
+  SemaphoreHandle_t statsMutex;
+  int64_t lastSweepTime;  // When last complete sweep published, 0 if sweep since abandoned
 
   Settings *settings;
 };
 
+const char *traceName(TraceMode mode);
+bool parseTrace(const char *name, TraceMode &mode);
+
 #endif
@@ -1,19 +1,41 @@
 #include "api.h"
 
+// Parse query parameter holding a plain non-negative number, as toInt() turns anything into a number
+// Returns false if it has any other characters or doesn't fit
+static bool parseUnsigned(const String &text, unsigned long &value) {
+  const char *start = text.c_str();
+  char *end;
+  errno = 0;
+  value = strtoul(start, &end, 10);
+  return isdigit(start[0]) && *end == '\0' && errno != ERANGE;
+}
+
 #ifdef BATTERY_MONITORING
 Api::Api(Settings *s, RX5808 *r, Battery *b)
-  : wifiOn(false), settings(s), receiver(r), battery(b),
-    server(80)
+  : wifiOn(false), pushedGeneration(0), bootId(esp_random()), valuesCacheNext(0), settings(s), receiver(r), battery(b),
+    server(80), ws("/api/ws"), wsDelta("/api/ws/delta")
 #else
 Api::Api(Settings *s, RX5808 *r)
-  : wifiOn(false), settings(s), receiver(r),
-    server(80)
+  : wifiOn(false), pushedGeneration(0), bootId(esp_random()), valuesCacheNext(0), settings(s), receiver(r),
+    server(80), ws("/api/ws"), wsDelta("/api/ws/delta")
 #endif
 {
+  valuesMutex = xSemaphoreCreateMutex();
+  waitingMutex = xSemaphoreCreateMutex();
+
   server.onNotFound([this](AsyncWebServerRequest *request) {
     handleNotFound(request);
   });
 
+  // Pushes every published sweep, see pushSweeps()
+  server.addHandler(&ws);
+
+  // New clients need a keyframe to apply changes to
+  wsDelta.onEvent([this](AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) deltaEncoder.requestKeyframe();
+  });
+  server.addHandler(&wsDelta);
+
   server.on("/api/values", HTTP_GET, [this](AsyncWebServerRequest *request) {
     handleGetValues(request);
   });
@@ -55,6 +77,30 @@ Api::Api(Settings *s, RX5808 *r)
     handleGetBattery(request);
   });
 #endif
+
+  server.on("/api/stats", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    handleGetStats(request);
+  });
+
+  server.on("/api/peaks", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    handleGetPeaks(request);
+  });
+
+  server.on("/api/history", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    handleGetHistory(request);
+  });
+
+  server.on("/api/finder", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    handleGetFinder(request);
+  });
+
+  server.on(
+    "/api/finder", HTTP_POST,
+    [](AsyncWebServerRequest *request) {},
+    NULL,
+    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      handlePostFinder(request, data, len, index, total);
+    });
 }
 
 // Start wifi hotspot
@@ -80,12 +126,61 @@ void Api::stopWifi() {
   // Do nothing if wifi already off
   if (!wifiOn) return;
 
+  xSemaphoreTake(waitingMutex, portMAX_DELAY);
+  waiting.clear();
+  xSemaphoreGive(waitingMutex);
+
+  ws.closeAll();
+  wsDelta.closeAll();
   server.end();
   WiFi.softAPdisconnect(true);
 
   wifiOn = false;
 }
 
+// Send sweep published since last call to every websocket client, and answer waiting /api/values requests
+// /api/ws clients get whole sweep packed as in packed.h, /api/ws/delta clients get frames from delta.h
+// Called from loop while Wi-Fi menu is open, so only latest sweep is sent if several were published in between
+void Api::pushSweeps() {
+  if (!wifiOn) return;
+  answerWaiting();
+  ws.cleanupClients();
+  wsDelta.cleanupClients();
+  if (ws.count() == 0 && wsDelta.count() == 0) return;
+
+  const Sweep *sweep = receiver->borrowSweep();
+  if (sweep->generation == 0 || sweep->generation == pushedGeneration) {
+    receiver->returnSweep(sweep);
+    return;
+  }
+  pushedGeneration = sweep->generation;
+
+  // Each frame built once and shared by every client
+  AsyncWebSocketSharedBuffer frame;
+  if (ws.count() > 0) {
+    frame = std::make_shared<std::vector<uint8_t>>(packedSweepSize(sweep, 16));
+    PackedBuffer buffer(frame->data(), frame->size());
+    writePackedSweep(buffer, sweep, LIVE, 16, receiver->settleTime.get());
+  }
+  AsyncWebSocketSharedBuffer delta;
+  if (wsDelta.count() > 0) {
+    size_t length = deltaEncoder.encode(sweep, receiver->settleTime.get(), settings->deltaThreshold.get(), deltaFrame, sizeof(deltaFrame));
+    delta = std::make_shared<std::vector<uint8_t>>(deltaFrame, deltaFrame + length);
+  }
+  receiver->returnSweep(sweep);
+
+  if (frame) broadcast(ws, frame);
+  if (delta) broadcast(wsDelta, delta);
+}
+
+// Send frame to every connected client that isn't behind
+// Full queue closes client, so slow clients skip this frame instead
+void Api::broadcast(AsyncWebSocket &socket, AsyncWebSocketSharedBuffer frame) {
+  for (AsyncWebSocketClient &client : socket.getClients()) {
+    if (client.status() == WS_CONNECTED && client.queueLen() < WS_MAX_QUEUED_SWEEPS) client.binary(frame);
+  }
+}
+
 // Return 404 not found error
 void Api::handleNotFound(AsyncWebServerRequest *request) {
   JsonDocument doc;
@@ -103,45 +198,195 @@ void Api::handleNotFound(AsyncWebServerRequest *request) {
 // Enpoint for getting scanned values
 // These values aren't actual rssi values, rather the analog-to-digital converter reading
 // Will be within a range of 0 to 4095 inclusive
+// Pass ?timestamps=true to also get time each value was scanned
+// Pass ?trace=max, min or average to get held or averaged values instead of latest readings
+// Pass ?format=binary or accept application/octet-stream to get values packed as in packed.h, ?bits=8 halves their size
+// Pass ?after=generation to wait for a newer sweep than the one given
 void Api::handleGetValues(AsyncWebServerRequest *request) {
-  JsonDocument doc;
+  ValuesOptions options;
+  options.timestamps = request->hasParam("timestamps") && request->getParam("timestamps")->value() == "true";
 
-  // Safely get lowband state
-  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-  bool lowband = receiver->lowband.get();
-  xSemaphoreGive(receiver->lowbandMutex);
+  options.trace = LIVE;
+  if (request->hasParam("trace") && !parseTrace(request->getParam("trace")->value().c_str(), options.trace)) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'trace' must be 'live', 'max', 'min' or 'average'\"}");
+    return;
+  }
 
-  // Add frequency information to json
-  int min_freq = lowband ? LOWBAND_MIN_FREQUENCY : HIGHBAND_MIN_FREQUENCY;
-  doc["lowband"] = lowband;
-  doc["min_frequency"] = min_freq;
-  doc["max_frequency"] = min_freq + SCAN_FREQUENCY_RANGE;
+  options.binary = (request->hasParam("format") && request->getParam("format")->value() == "binary")
+                   || (request->hasHeader("Accept") && request->header("Accept").indexOf("application/octet-stream") >= 0);
+  options.bits = options.binary && request->hasParam("bits") ? request->getParam("bits")->value().toInt() : 16;
+  if (options.bits != 8 && options.bits != 16) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'bits' must be 8 or 16\"}");
+    return;
+  }
+
+  unsigned long after = 0;
+  if (request->hasParam("after") && !parseUnsigned(request->getParam("after")->value(), after)) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'after' must be a non-negative integer\"}");
+    return;
+  }
+
+  // Borrow latest complete sweep so all values are from the same pass
+  const Sweep *sweep = receiver->borrowSweep();
+
+  if (request->hasParam("after") && sweep->generation <= after && waitForValues(request, after, options)) {
+    receiver->returnSweep(sweep);
+    return;
+  }
+
+  sendValues(request, sweep, options);
+  receiver->returnSweep(sweep);
+}
 
-  // Calculate number of scanned values based off of interval
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
-  float interval = settings->scanInterval.get();
-  xSemaphoreGive(settings->settingsMutex);
-  int numScannedValues = (SCAN_FREQUENCY_RANGE / interval) + 1;  // +1 for final number inclusion
+// Send values from sweep with its etag, or 304 if client already holds them
+void Api::sendValues(AsyncWebServerRequest *request, const Sweep *sweep, const ValuesOptions &options) {
+  char etag[ETAG_LENGTH];
+  snprintf(etag, sizeof(etag), "\"%08lx-%lu-%d\"", (unsigned long)bootId, (unsigned long)sweep->generation, options.variant());
+  if (notModified(request, etag)) return;
+
+  xSemaphoreTake(valuesMutex, portMAX_DELAY);
+  const CachedResponse *cached = cacheValues(sweep, options);
+  sendCached(request, *cached, options.binary ? "application/octet-stream" : "application/json", etag);
+  xSemaphoreGive(valuesMutex);
+}
+
+// Hold request open until sweep newer than after is published, see answerWaiting()
+// Request is paused rather than blocking server task, so it's answered through the same path as other requests
+// Returns false if too many requests are already waiting
+bool Api::waitForValues(AsyncWebServerRequest *request, uint32_t after, const ValuesOptions &options) {
+  xSemaphoreTake(waitingMutex, portMAX_DELAY);
+  bool queued = waiting.size() < LONG_POLL_MAX_WAITING;
+  if (queued) {
+    request->pause();
+    waiting.push_back({ request->getRequestPtr(), after, options, millis() });
+  }
+  xSemaphoreGive(waitingMutex);
+  return queued;
+}
+
+// Answer waiting requests once sweep newer than theirs is published, or LONG_POLL_TIMEOUT passes and latest is sent anyway
+// Requests whose client disconnected are dropped
+void Api::answerWaiting() {
+  xSemaphoreTake(waitingMutex, portMAX_DELAY);
+  if (!waiting.empty()) {
+    const Sweep *sweep = receiver->borrowSweep();
+    unsigned long now = millis();
+
+    for (auto it = waiting.begin(); it != waiting.end();) {
+      if (!it->request.expired() && sweep->generation <= it->after && now - it->start < LONG_POLL_TIMEOUT) {
+        it++;
+        continue;
+      }
+      if (auto request = it->request.lock()) sendValues(request.get(), sweep, it->options);
+      it = waiting.erase(it);
+    }
+
+    receiver->returnSweep(sweep);
+  }
+  xSemaphoreGive(waitingMutex);
+}
+
+// Body for sweep with given options, built if not already cached
+// Every request for the same sweep and options gets the same body, so it's only built once
+const CachedResponse *Api::cacheValues(const Sweep *sweep, const ValuesOptions &options) {
+  int variant = options.variant();
+
+  CachedResponse *replace = nullptr;
+  for (int i = 0; i < VALUES_CACHE_SLOTS; i++) {
+    CachedResponse &slot = valuesCache[i];
+    if (slot.valid && slot.version == sweep->generation && slot.variant == variant) return &slot;
+    if (!replace && (!slot.valid || slot.version != sweep->generation)) replace = &slot;
+  }
+
+  // Take slot holding an old sweep, otherwise take turns
+  if (!replace) replace = &valuesCache[valuesCacheNext++ % VALUES_CACHE_SLOTS];
+  replace->valid = true;
+  replace->version = sweep->generation;
+  replace->variant = variant;
+
+  if (options.binary) {
+    // Written straight from sweep buffer, no json document needed
+    replace->body.resize(packedSweepSize(sweep, options.bits));
+    PackedBuffer buffer(replace->body.data(), replace->body.size());
+    writePackedSweep(buffer, sweep, options.trace, options.bits, receiver->settleTime.get());
+  } else {
+    JsonDocument doc;
+    buildValues(doc, sweep, options.trace, options.timestamps);
+    serializeCached(doc, *replace);
+  }
+  return replace;
+}
+
+// Fill json body of values response from sweep
+void Api::buildValues(JsonDocument &doc, const Sweep *sweep, TraceMode trace, bool timestamps) {
+  // Add frequency information to json
+  doc["lowband"] = sweep->plan.lowband;
+  doc["min_frequency"] = sweep->plan.minFrequency;
+  doc["max_frequency"] = sweep->plan.maxFrequency;
+  doc["interval_khz"] = sweep->plan.intervalKhz;
+  doc["focus"] = sweep->plan.mode == FOCUS;
+  doc["generation"] = sweep->generation;
+  doc["timestamp"] = sweep->timestamp;
+  doc["complete"] = sweep->complete;
+  doc["trace"] = traceName(trace);
+
+  // Add time waited for rssi to settle on last step
+  doc["settle_time"] = receiver->settleTime.get();
 
   JsonArray values = doc["values"].to<JsonArray>();
 
-  for (int i = 0; i < numScannedValues; i++) {
-    // Safely get current rssi
-    int rssi;
-    xSemaphoreTake(receiver->scanMutex, portMAX_DELAY);
-    rssi = receiver->rssiValues.get(i);
-    xSemaphoreGive(receiver->scanMutex);
+  for (int i = 0; i < sweep->plan.length; i++) {
+    values.add(sweep->trace(trace, i));
+  }
 
-    values.add(rssi);
+  // Channel table isn't evenly spaced, so give frequency and name of each value
+  if (sweep->plan.mode == CHANNELS) {
+    JsonArray frequencies = doc["frequencies"].to<JsonArray>();
+    JsonArray channels = doc["channels"].to<JsonArray>();
+    for (int i = 0; i < sweep->plan.length; i++) {
+      frequencies.add(sweep->plan.frequency(i));
+      channels.add(sweep->plan.channel(i));
+    }
   }
 
-  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  // Time each value was last scanned, may differ greatly in priority sweep order
+  if (timestamps) {
+    JsonArray updated = doc["updated"].to<JsonArray>();
+    for (int i = 0; i < sweep->plan.length; i++) {
+      updated.add(sweep->updated.get(i));
+    }
+  }
+}
 
-  serializeJson(doc, *response);
+// Send 304 if client already holds response with etag
+// Returns true if sent
+bool Api::notModified(AsyncWebServerRequest *request, const char *etag) {
+  if (!request->hasHeader("If-None-Match") || request->header("If-None-Match") != etag) return false;
+
+  AsyncWebServerResponse *response = request->beginResponse(304);
+  response->addHeader("ETag", etag);
+  request->send(response);
+  return true;
+}
+
+// Serialise json into cached body
+void Api::serializeCached(JsonDocument &doc, CachedResponse &cached) {
+  // Room for null terminator written by serializeJson()
+  size_t length = measureJson(doc);
+  cached.body.resize(length + 1);
+  serializeJson(doc, (char *)cached.body.data(), cached.body.size());
+  cached.body.resize(length);
+}
+
+// Send copy of cached body, so cache can be replaced while response is still being sent
+void Api::sendCached(AsyncWebServerRequest *request, const CachedResponse &cached, const char *contentType, const char *etag) {
+  AsyncResponseStream *response = request->beginResponseStream(contentType, cached.body.size());
+  response->addHeader("ETag", etag);
+  response->write(cached.body.data(), cached.body.size());
   request->send(response);
 }
 
-// Endpoint for setting high or low band
+// Endpoint for setting high or low band, focusing on a frequency, and restarting traces
 void Api::handlePostValues(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
   JsonDocument doc;
 
@@ -152,52 +397,104 @@ void Api::handlePostValues(AsyncWebServerRequest *request, uint8_t *data, size_t
     return;
   }
 
-  // Check keys
-  if (doc.size() != 1 || !doc["lowband"].is<JsonVariant>()) {
-    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'lowband' must be the only key\"}");
+  // Only lowband, focus and reset_traces keys allowed, at least one required
+  if (doc.size() == 0) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'lowband', 'focus' and 'reset_traces' keys are allowed\"}");
     return;
   }
+  for (JsonPair kv : doc.as<JsonObject>()) {
+    const char *key = kv.key().c_str();
+    if (strcmp(key, "lowband") != 0 && strcmp(key, "focus") != 0 && strcmp(key, "reset_traces") != 0) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'lowband', 'focus' and 'reset_traces' keys are allowed\"}");
+      return;
+    }
+  }
 
-  // Check key type
-  if (!doc["lowband"].is<bool>()) {
+  // Check lowband type
+  if (doc["lowband"].is<JsonVariant>() && !doc["lowband"].is<bool>()) {
     request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'lowband' must be a boolean\"}");
     return;
   }
 
-  // Update receiver lowband state
-  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-  receiver->lowband.set(doc["lowband"]);
-  xSemaphoreGive(receiver->lowbandMutex);
+  // Check reset_traces type
+  if (doc["reset_traces"].is<JsonVariant>() && !doc["reset_traces"].is<bool>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'reset_traces' must be a boolean\"}");
+    return;
+  }
+
+  // Check focus type and value, 0 returns to full sweep
+  if (doc["focus"].is<JsonVariant>()) {
+    if (!doc["focus"].is<int>()) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'focus' must be an integer\"}");
+      return;
+    }
+    int focus = doc["focus"];
+    if (focus != 0 && (focus < RX5808_MIN_FREQUENCY || focus > RX5808_MAX_FREQUENCY)) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'focus' must be 0 or between 5300 and 6000 inclusive\"}");
+      return;
+    }
+  }
+
+  // Update receiver lowband and focus state
+  if (doc["lowband"].is<JsonVariant>() || doc["focus"].is<JsonVariant>()) {
+    xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+    if (doc["lowband"].is<JsonVariant>()) receiver->lowband.set(doc["lowband"]);
+    if (doc["focus"].is<JsonVariant>()) receiver->focusFrequency.set(doc["focus"]);
+    xSemaphoreGive(receiver->lowbandMutex);
+    receiver->reconfigure();
+  }
+
+  if (doc["reset_traces"] == true) receiver->resetTraces();
 
   request->send(200, "application/json", "{\"status\":\"ok\"}");
 }
 
 // Endpoint for getting settings indices
-// Scan interval settings { 2.5, 5, 10 }
+// Scan interval settings { 2.5, 5, 10, Channels, Custom }
+// Sweep order settings { Linear, Bit-reversed, Interleaved, Priority }
+// Trace settings { Live, Max hold, Min hold, Average }
 // Buzzer settings { On, Off }
 // Battery alarm settings { 3.6, 3.3, 3.0 }
 void Api::handleGetSettings(AsyncWebServerRequest *request) {
+  // Read revision first, so a change while building is picked up by next request
+  uint32_t revision = settings->revision.get();
+
+  char etag[ETAG_LENGTH];
+  snprintf(etag, sizeof(etag), "\"%08lx-%lu\"", (unsigned long)bootId, (unsigned long)revision);
+  if (notModified(request, etag)) return;
+
+  if (settingsCache.valid && settingsCache.version == revision) {
+    sendCached(request, settingsCache, "application/json", etag);
+    return;
+  }
+
   JsonDocument doc;
 
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   doc["scan_interval_index"] = settings->scanIntervalIndex.get();
-  doc["scan_interval"] = settings->scanInterval.get();
+  doc["scan_interval"] = settings->scanIntervalKhz.get() / 1000.0;
+  doc["sweep_order_index"] = settings->sweepOrderIndex.get();
+  doc["trace_index"] = settings->traceIndex.get();
+  doc["range_start"] = settings->rangeStart.get();
+  doc["range_stop"] = settings->rangeStop.get();
+  doc["range_step"] = settings->rangeStep.get();
+  doc["delta_threshold"] = settings->deltaThreshold.get();
   doc["buzzer_index"] = settings->buzzerIndex.get();
   doc["buzzer"] = settings->buzzer.get();
 #ifdef BATTERY_MONITORING
   doc["battery_alarm_index"] = settings->batteryAlarmIndex.get();
   doc["battery_alarm"] = settings->batteryAlarm.get();
 #endif
-  xSemaphoreGive(settings->settingsMutex);
 
-  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  settingsCache.valid = true;
+  settingsCache.version = revision;
+  serializeCached(doc, settingsCache);
 
-  serializeJson(doc, *response);
-  request->send(response);
+  sendCached(request, settingsCache, "application/json", etag);
 }
 
 // Endpoint for updating settings indices
-// Scan interval settings { 2.5, 5, 10 }
+// Scan interval settings { 2.5, 5, 10, Channels, Custom }
+// Sweep order settings { Linear, Bit-reversed, Interleaved, Priority }
 // Buzzer settings { On, Off }
 // Battery alarm settings { 3.6, 3.3, 3.0 }
 void Api::handlePostSettings(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
@@ -211,20 +508,20 @@ void Api::handlePostSettings(AsyncWebServerRequest *request, uint8_t *data, size
   }
 
 #ifdef BATTERY_MONITORING
-  // Only scan_interval_index, buzzer_index and battery_alarm_index keys allowed
+  // Only scan_interval_index, sweep_order_index, trace_index, range_start, range_stop, range_step, delta_threshold, buzzer_index and battery_alarm_index keys allowed
   for (JsonPair kv : doc.as<JsonObject>()) {
     const char *key = kv.key().c_str();
-    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "buzzer_index") != 0 && strcmp(key, "battery_alarm_index") != 0) {
-      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'scan_interval_index', 'buzzer_index' and 'battery_alarm_index' keys are allowed\"}");
+    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "sweep_order_index") != 0 && strcmp(key, "trace_index") != 0 && strcmp(key, "range_start") != 0 && strcmp(key, "range_stop") != 0 && strcmp(key, "range_step") != 0 && strcmp(key, "delta_threshold") != 0 && strcmp(key, "buzzer_index") != 0 && strcmp(key, "battery_alarm_index") != 0) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'scan_interval_index', 'sweep_order_index', 'trace_index', 'range_start', 'range_stop', 'range_step', 'delta_threshold', 'buzzer_index' and 'battery_alarm_index' keys are allowed\"}");
       return;
     }
   }
 #else
-  // Only scan_interval_index and buzzer_index keys allowed
+  // Only scan_interval_index, sweep_order_index, trace_index, range_start, range_stop, range_step, delta_threshold and buzzer_index keys allowed
   for (JsonPair kv : doc.as<JsonObject>()) {
     const char *key = kv.key().c_str();
-    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "buzzer_index") != 0) {
-      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'scan_interval_index' and 'buzzer_index' keys are allowed\"}");
+    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "sweep_order_index") != 0 && strcmp(key, "trace_index") != 0 && strcmp(key, "range_start") != 0 && strcmp(key, "range_stop") != 0 && strcmp(key, "range_step") != 0 && strcmp(key, "delta_threshold") != 0 && strcmp(key, "buzzer_index") != 0) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'scan_interval_index', 'sweep_order_index', 'trace_index', 'range_start', 'range_stop', 'range_step', 'delta_threshold' and 'buzzer_index' keys are allowed\"}");
       return;
     }
   }
@@ -236,8 +533,75 @@ void Api::handlePostSettings(AsyncWebServerRequest *request, uint8_t *data, size
       request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'scan_interval_index' must be an integer\"}");
       return;
     }
-    if (doc["scan_interval_index"] < 0 || doc["scan_interval_index"] > 2) {
-      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'scan_interval_index' must be between 0 and 2 inclusive\"}");
+    if (doc["scan_interval_index"] < 0 || doc["scan_interval_index"] > 4) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'scan_interval_index' must be between 0 and 4 inclusive\"}");
+      return;
+    }
+  }
+
+  // Validate type and value of sweep_order_index
+  if (doc["sweep_order_index"].is<JsonVariant>()) {
+    if (!doc["sweep_order_index"].is<int>()) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'sweep_order_index' must be an integer\"}");
+      return;
+    }
+    if (doc["sweep_order_index"] < 0 || doc["sweep_order_index"] > 3) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'sweep_order_index' must be between 0 and 3 inclusive\"}");
+      return;
+    }
+  }
+
+  // Validate type and value of trace_index
+  if (doc["trace_index"].is<JsonVariant>()) {
+    if (!doc["trace_index"].is<int>()) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'trace_index' must be an integer\"}");
+      return;
+    }
+    if (doc["trace_index"] < 0 || doc["trace_index"] > 3) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'trace_index' must be between 0 and 3 inclusive\"}");
+      return;
+    }
+  }
+
+  // Validate type of range_start
+  if (doc["range_start"].is<JsonVariant>() && !doc["range_start"].is<int>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'range_start' must be an integer\"}");
+    return;
+  }
+
+  // Validate type of range_stop
+  if (doc["range_stop"].is<JsonVariant>() && !doc["range_stop"].is<int>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'range_stop' must be an integer\"}");
+    return;
+  }
+
+  // Validate type of range_step
+  if (doc["range_step"].is<JsonVariant>() && !doc["range_step"].is<int>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'range_step' must be an integer\"}");
+    return;
+  }
+
+  // Validate custom range, missing keys keep current value
+  int rangeStart = doc["range_start"] | settings->rangeStart.get();
+  int rangeStop = doc["range_stop"] | settings->rangeStop.get();
+  int rangeStep = doc["range_step"] | settings->rangeStep.get();
+  if (rangeStart < RX5808_MIN_FREQUENCY || rangeStop > RX5808_MAX_FREQUENCY || rangeStart >= rangeStop) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'range_start' must be less than 'range_stop', both between 5300 and 6000 inclusive\"}");
+    return;
+  }
+  if (rangeStep < 1 || rangeStep > rangeStop - rangeStart) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'range_step' must be between 1 and the width of the range inclusive\"}");
+    return;
+  }
+
+  // Validate type and value of delta_threshold
+  if (doc["delta_threshold"].is<JsonVariant>()) {
+    if (!doc["delta_threshold"].is<int>()) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'delta_threshold' must be an integer\"}");
+      return;
+    }
+    if (doc["delta_threshold"] < 0 || doc["delta_threshold"] > MAX_DELTA_THRESHOLD) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'delta_threshold' must be between 0 and 255 inclusive\"}");
       return;
     }
   }
@@ -273,10 +637,34 @@ void Api::handlePostSettings(AsyncWebServerRequest *request, uint8_t *data, size
     xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
     settings->scanIntervalIndex.set(doc["scan_interval_index"]);
     xSemaphoreGive(settings->settingsMutex);
+  }
+  if (doc["sweep_order_index"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->sweepOrderIndex.set(doc["sweep_order_index"]);
+    xSemaphoreGive(settings->settingsMutex);
+  }
+  if (doc["trace_index"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->traceIndex.set(doc["trace_index"]);
+    xSemaphoreGive(settings->settingsMutex);
+    receiver->resetTraces();
+  }
+  if (doc["range_start"].is<JsonVariant>() || doc["range_stop"].is<JsonVariant>() || doc["range_step"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->rangeStart.set(rangeStart);
+    settings->rangeStop.set(rangeStop);
+    settings->rangeStep.set(rangeStep);
+    xSemaphoreGive(settings->settingsMutex);
+  }
 
-    // Need to restart scanning for interval update to work
-    receiver->stopScan();
-    receiver->startScan();
+  // Scanning picks up new interval, order and range from next step
+  if (doc["scan_interval_index"].is<JsonVariant>() || doc["sweep_order_index"].is<JsonVariant>() || doc["range_start"].is<JsonVariant>() || doc["range_stop"].is<JsonVariant>() || doc["range_step"].is<JsonVariant>()) {
+    receiver->reconfigure();
+  }
+  if (doc["delta_threshold"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->deltaThreshold.set(doc["delta_threshold"]);
+    xSemaphoreGive(settings->settingsMutex);
   }
   if (doc["buzzer_index"].is<JsonVariant>()) {
     xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
@@ -299,17 +687,41 @@ void Api::handlePostSettings(AsyncWebServerRequest *request, uint8_t *data, size
 // These values aren't actual rssi values, rather the analog-to-digital converter reading
 // Will be within a range of 0 to 4095 inclusive
 void Api::handleGetCalibration(AsyncWebServerRequest *request) {
+  // Read revision first, so a change while building is picked up by next request
+  uint32_t revision = settings->revision.get();
+  bool autoTuning = receiver->autoTuning.get();
+
+  char etag[ETAG_LENGTH];
+  snprintf(etag, sizeof(etag), "\"%08lx-%lu-%d\"", (unsigned long)bootId, (unsigned long)revision, autoTuning);
+  if (notModified(request, etag)) return;
+
+  if (calibrationCache.valid && calibrationCache.version == revision && calibrationCache.variant == autoTuning) {
+    sendCached(request, calibrationCache, "application/json", etag);
+    return;
+  }
+
   JsonDocument doc;
 
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   doc["low_rssi"] = settings->lowCalibratedRssi.get();
   doc["high_rssi"] = settings->highCalibratedRssi.get();
-  xSemaphoreGive(settings->settingsMutex);
 
-  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  // Auto-tuned dwell and samples, 0 if not tuned
+  doc["settle_time"] = settings->tunedSettleTime.get();
+  doc["rssi_samples"] = settings->tunedSamples.get();
+  doc["auto_tuning"] = autoTuning;
 
-  serializeJson(doc, *response);
-  request->send(response);
+  // Added to readings from each module so they match first module
+  JsonArray offsets = doc["rssi_offsets"].to<JsonArray>();
+  for (int i = 0; i < receiver->getModules(); i++) {
+    offsets.add(settings->rssiOffsets[i].get());
+  }
+
+  calibrationCache.valid = true;
+  calibrationCache.version = revision;
+  calibrationCache.variant = autoTuning;
+  serializeCached(doc, calibrationCache);
+
+  sendCached(request, calibrationCache, "application/json", etag);
 }
 
 // Endpoint for setting high and low calibration values
@@ -324,20 +736,19 @@ void Api::handlePostCalibration(AsyncWebServerRequest *request, uint8_t *data, s
     return;
   }
 
-  // Only high_rssi and low_rssi keys allowed
+  // Only high_rssi, low_rssi, auto_tune and rssi_offsets keys allowed
   for (JsonPair kv : doc.as<JsonObject>()) {
     const char *key = kv.key().c_str();
-    if (strcmp(key, "high_rssi") != 0 && strcmp(key, "low_rssi") != 0) {
-      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'high_rssi' and 'low_rssi' keys are allowed\"}");
+    if (strcmp(key, "high_rssi") != 0 && strcmp(key, "low_rssi") != 0 && strcmp(key, "auto_tune") != 0
+        && strcmp(key, "rssi_offsets") != 0) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"only 'high_rssi', 'low_rssi', 'auto_tune' and 'rssi_offsets' keys are allowed\"}");
       return;
     }
   }
 
   // Safely get calibrated rssi values
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   int newHigh = settings->highCalibratedRssi.get();
   int newLow = settings->lowCalibratedRssi.get();
-  xSemaphoreGive(settings->settingsMutex);
 
   // Validate type and value of high_rssi
   if (doc["high_rssi"].is<JsonVariant>()) {
@@ -365,6 +776,26 @@ void Api::handlePostCalibration(AsyncWebServerRequest *request, uint8_t *data, s
     }
   }
 
+  // Validate type of auto_tune
+  if (doc["auto_tune"].is<JsonVariant>() && !doc["auto_tune"].is<bool>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'auto_tune' must be a boolean\"}");
+    return;
+  }
+
+  // Validate rssi_offsets, one for each module
+  if (doc["rssi_offsets"].is<JsonVariant>()) {
+    if (!doc["rssi_offsets"].is<JsonArray>() || doc["rssi_offsets"].size() != (size_t)receiver->getModules()) {
+      request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'rssi_offsets' must be an array with an offset for each module\"}");
+      return;
+    }
+    for (JsonVariant offset : doc["rssi_offsets"].as<JsonArray>()) {
+      if (!offset.is<int>() || offset.as<int>() < -4095 || offset.as<int>() > 4095) {
+        request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'rssi_offsets' must be integers between -4095 and 4095 inclusive\"}");
+        return;
+      }
+    }
+  }
+
   // high_rssi must be greater than low_rssi
   if (newHigh <= newLow) {
     request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'high_rssi' must be greater than 'low_rssi' (considering new or existing values)\"}");
@@ -383,6 +814,17 @@ void Api::handlePostCalibration(AsyncWebServerRequest *request, uint8_t *data, s
     xSemaphoreGive(settings->settingsMutex);
   }
 
+  if (doc["rssi_offsets"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    for (int i = 0; i < receiver->getModules(); i++) {
+      settings->rssiOffsets[i].set(doc["rssi_offsets"][i]);
+    }
+    xSemaphoreGive(settings->settingsMutex);
+  }
+
+  // Scanning task runs auto-tune in background, poll auto_tuning to see when finished
+  if (doc["auto_tune"] | false) receiver->requestAutoTune();
+
   request->send(200, "application/json", "{\"status\":\"ok\"}");
 }
 
@@ -391,9 +833,7 @@ void Api::handlePostCalibration(AsyncWebServerRequest *request, uint8_t *data, s
 void Api::handleGetBattery(AsyncWebServerRequest *request) {
   JsonDocument doc;
 
-  xSemaphoreTake(battery->batteryMutex, portMAX_DELAY);
   doc["voltage"] = battery->currentVoltage.get();
-  xSemaphoreGive(battery->batteryMutex);
 
   AsyncResponseStream *response = request->beginResponseStream("application/json");
 
@@ -401,3 +841,181 @@ void Api::handleGetBattery(AsyncWebServerRequest *request) {
   request->send(response);
 }
 #endif
+
+// Endpoint for getting transmitters found in complete sweeps
+// Peaks keep the same id while tracked, times in ms since boot
+void Api::handleGetPeaks(AsyncWebServerRequest *request) {
+  JsonDocument doc;
+
+  PeakList list = receiver->getPeaks();
+
+  doc["generation"] = list.generation;
+  doc["noise_floor"] = list.noiseFloor;
+
+  JsonArray peaks = doc["peaks"].to<JsonArray>();
+  for (int i = 0; i < list.length; i++) {
+    JsonObject peak = peaks.add<JsonObject>();
+    peak["id"] = list.peaks[i].id;
+    peak["frequency"] = list.peaks[i].frequency;
+    peak["bandwidth_khz"] = list.peaks[i].bandwidthKhz;
+    peak["rssi"] = list.peaks[i].rssi;
+    peak["prominence"] = list.peaks[i].prominence;
+    peak["first_seen"] = list.peaks[i].firstSeen;
+    peak["last_seen"] = list.peaks[i].lastSeen;
+  }
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+
+  serializeJson(doc, *response);
+  request->send(response);
+}
+
+// Endpoint for getting complete sweeps kept in history, oldest first
+// Pass ?from=N and ?to=N to only get sweeps published in that range, in ms since boot
+// Readings are quantised to 8 bits and sent as 2 hex digits each
+void Api::handleGetHistory(AsyncWebServerRequest *request) {
+  JsonDocument doc;
+
+  unsigned long from = 0;
+  if (request->hasParam("from") && !parseUnsigned(request->getParam("from")->value(), from)) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'from' must be a non-negative integer\"}");
+    return;
+  }
+  unsigned long to = ULONG_MAX;
+  if (request->hasParam("to") && !parseUnsigned(request->getParam("to")->value(), to)) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'to' must be a non-negative integer\"}");
+    return;
+  }
+
+  ScanPlan plan;
+  bool more;
+  int length = receiver->getHistory(from, to, historyRecords, HISTORY_RESPONSE_SWEEPS, historyValues, HISTORY_RESPONSE_BYTES, plan, more);
+
+  // Add frequency information to json
+  doc["lowband"] = plan.lowband;
+  doc["min_frequency"] = plan.minFrequency;
+  doc["max_frequency"] = plan.maxFrequency;
+  doc["interval_khz"] = plan.intervalKhz;
+  doc["focus"] = plan.mode == FOCUS;
+  doc["shift"] = HISTORY_SHIFT;
+  doc["more"] = more;
+
+  // Channel table isn't evenly spaced, so give frequency of each value
+  if (plan.mode == CHANNELS) {
+    JsonArray frequencies = doc["frequencies"].to<JsonArray>();
+    for (int i = 0; i < plan.length; i++) {
+      frequencies.add(plan.frequency(i));
+    }
+  }
+
+  JsonArray sweeps = doc["sweeps"].to<JsonArray>();
+  for (int i = 0; i < length; i++) {
+    for (int j = 0; j < plan.length; j++) {
+      snprintf(&historyHex[j * 2], 3, "%02x", historyValues[i * plan.length + j]);
+    }
+    historyHex[plan.length * 2] = '\0';
+
+    JsonObject sweep = sweeps.add<JsonObject>();
+    sweep["generation"] = historyRecords[i].generation;
+    sweep["timestamp"] = historyRecords[i].timestamp;
+    sweep["values"] = historyHex;
+  }
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+
+  serializeJson(doc, *response);
+  request->send(response);
+}
+
+// Endpoint for getting scan timing statistics since last reconfigure
+// All times in us
+void Api::handleGetStats(AsyncWebServerRequest *request) {
+  JsonDocument doc;
+
+  ScanStats stats = receiver->getStats();
+
+  doc["steps"] = stats.steps;
+  doc["mean_jitter"] = stats.steps > 0 ? stats.totalJitter / stats.steps : 0;
+  doc["max_jitter"] = stats.maxJitter;
+  doc["sweeps"] = stats.sweeps;
+  doc["last_sweep_period"] = stats.lastSweepPeriod;
+  doc["min_sweep_period"] = stats.minSweepPeriod;
+  doc["max_sweep_period"] = stats.maxSweepPeriod;
+  doc["mean_sweep_period"] = stats.sweeps > 0 ? stats.totalSweepPeriod / stats.sweeps : 0;
+  doc["transport"] = stats.transport;
+  doc["mean_retune_time"] = stats.retunes > 0 ? stats.totalRetuneTime / stats.retunes : 0;
+  doc["max_retune_time"] = stats.maxRetuneTime;
+  doc["stack_free"] = stats.stackFree;
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+
+  serializeJson(doc, *response);
+  request->send(response);
+}
+
+// Endpoint for getting finder readings
+// Pass ?after=N to only get readings numbered N or later, using 'next' from previous response
+void Api::handleGetFinder(AsyncWebServerRequest *request) {
+  JsonDocument doc;
+
+  unsigned long after = 0;
+  if (request->hasParam("after") && !parseUnsigned(request->getParam("after")->value(), after)) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'after' must be a non-negative integer\"}");
+    return;
+  }
+
+  uint32_t first;
+  int length = receiver->getFinderTrace(finderTrace, FINDER_TRACE_LENGTH, after, first);
+
+  doc["frequency"] = receiver->finderFrequency.get();
+  doc["rssi"] = receiver->finderRssi.get();
+  doc["first"] = first;
+  doc["next"] = first + length;
+
+  JsonArray values = doc["trace"].to<JsonArray>();
+  for (int i = 0; i < length; i++) {
+    values.add(finderTrace[i]);
+  }
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+
+  serializeJson(doc, *response);
+  request->send(response);
+}
+
+// Endpoint for starting finder on a frequency, or stopping with 0
+void Api::handlePostFinder(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  JsonDocument doc;
+
+  // Deserialise and validate json
+  DeserializationError error = deserializeJson(doc, data, len);
+  if (error) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"invalid JSON\"}");
+    return;
+  }
+
+  // Check keys
+  if (doc.size() != 1 || !doc["frequency"].is<JsonVariant>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'frequency' must be the only key\"}");
+    return;
+  }
+
+  // Check key type and value
+  if (!doc["frequency"].is<int>()) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'frequency' must be an integer\"}");
+    return;
+  }
+  int frequency = doc["frequency"];
+  if (frequency != 0 && (frequency < RX5808_MIN_FREQUENCY || frequency > RX5808_MAX_FREQUENCY)) {
+    request->send(400, "application/json", "{\"status\":\"error\", \"payload\":\"'frequency' must be 0 or between 5300 and 6000 inclusive\"}");
+    return;
+  }
+
+  // Update receiver finder state
+  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+  receiver->finderFrequency.set(frequency);
+  xSemaphoreGive(receiver->lowbandMutex);
+  receiver->reconfigure();
+
+  request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
@@ -6,6 +6,8 @@
 #include <ESPAsyncWebServer.h>
 #include <WiFi.h>
 #include "battery.h"
+#include "delta.h"
+#include "packed.h"
 #include "RX5808.h"
 #include "settings.h"
 
@@ -15,6 +17,46 @@
 #define WIFI_GATEWAY WIFI_IP
 #define WIFI_SUBNET "255.255.255.0"
 
+// Sweeps pushed to websocket clients as they're published
+// Clients with this many messages still queued miss sweeps until they catch up, rather than queueing more
+#define WS_MAX_QUEUED_SWEEPS 2
+
+// Bodies of get responses are built once and reused until what they hold changes
+#define VALUES_CACHE_SLOTS 2  // Different combinations of /api/values options cached at once
+#define ETAG_LENGTH 32
+
+#define LONG_POLL_TIMEOUT 10000  // Longest time in ms /api/values?after= waits for a newer sweep
+#define LONG_POLL_MAX_WAITING 4  // Requests held open at once, any more are answered straight away
+
+// Query options of /api/values
+struct ValuesOptions {
+  TraceMode trace;
+  bool timestamps;
+  bool binary;
+  int bits;
+
+  // Each combination gets its own cached body and etag
+  int variant() const {
+    return trace | (timestamps ? 0x04 : 0) | (binary ? 0x08 : 0) | (bits == 8 ? 0x10 : 0);
+  }
+};
+
+// /api/values?after= request held open until a newer sweep is published
+struct WaitingRequest {
+  AsyncWebServerRequestPtr request;  // Expires if client disconnects while waiting
+  uint32_t after;
+  ValuesOptions options;
+  unsigned long start;  // ms
+};
+
+// Serialised response body, and version of data it was built from
+struct CachedResponse {
+  bool valid = false;
+  uint32_t version = 0;  // Sweep generation or settings revision
+  int variant = 0;       // Request options body was built for
+  std::vector<uint8_t> body;
+};
+
 // Holds state and responses for wifi and api
 class Api {
 public:
@@ -25,6 +67,7 @@ public:
 #endif
   void startWifi();
   void stopWifi();
+  void pushSweeps();
 
 private:
   void handleNotFound(AsyncWebServerRequest *request);
@@ -37,10 +80,55 @@ private:
 #ifdef BATTERY_MONITORING
   void handleGetBattery(AsyncWebServerRequest *request);
 #endif
+  void handleGetStats(AsyncWebServerRequest *request);
+  void handleGetPeaks(AsyncWebServerRequest *request);
+  void handleGetHistory(AsyncWebServerRequest *request);
+  void handleGetFinder(AsyncWebServerRequest *request);
+  void handlePostFinder(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+  void broadcast(AsyncWebSocket &socket, AsyncWebSocketSharedBuffer frame);
+  bool waitForValues(AsyncWebServerRequest *request, uint32_t after, const ValuesOptions &options);
+  void answerWaiting();
+  void sendValues(AsyncWebServerRequest *request, const Sweep *sweep, const ValuesOptions &options);
+  const CachedResponse *cacheValues(const Sweep *sweep, const ValuesOptions &options);
+  void buildValues(JsonDocument &doc, const Sweep *sweep, TraceMode trace, bool timestamps);
+  bool notModified(AsyncWebServerRequest *request, const char *etag);
+  void serializeCached(JsonDocument &doc, CachedResponse &cached);
+  void sendCached(AsyncWebServerRequest *request, const CachedResponse &cached, const char *contentType, const char *etag);
 
   bool wifiOn;
+  uint32_t pushedGeneration;  // Last sweep pushed to websocket clients
+
+  // Delta frames for /api/ws/delta, encoded once and shared by every client
+  DeltaEncoder deltaEncoder;
+  uint8_t deltaFrame[PACKED_MAX_SIZE];
+
+  // Differs every boot, so etags from before a restart don't match
+  uint32_t bootId;
+
+  // Guarded by valuesMutex, as waiting requests are answered from loop
+  // Lock order is waitingMutex before valuesMutex
+  CachedResponse valuesCache[VALUES_CACHE_SLOTS];
+  int valuesCacheNext;
+  SemaphoreHandle_t valuesMutex;
+
+  std::vector<WaitingRequest> waiting;
+  SemaphoreHandle_t waitingMutex;
+
+  // Only used by web server task
+  CachedResponse settingsCache;
+  CachedResponse calibrationCache;
+
+  // History copied for responses, too big for server task stack
+  HistoryRecord historyRecords[HISTORY_RESPONSE_SWEEPS];
+  uint8_t historyValues[HISTORY_RESPONSE_BYTES];
+  char historyHex[MAX_FREQUENCIES_SCANNED * 2 + 1];
+
+  // Finder readings copied for responses, too big for server task stack
+  uint16_t finderTrace[FINDER_TRACE_LENGTH];
 
   AsyncWebServer server;
+  AsyncWebSocket ws;
+  AsyncWebSocket wsDelta;
 
   Settings *settings;
   RX5808 *receiver;
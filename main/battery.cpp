@@ -30,14 +30,10 @@ void Battery::updateBatteryVoltage() {
 
 // Battery below alarm threshold for long enough to be considered "low"
 bool Battery::lowBattery() {
-  xSemaphoreTake(batteryMutex, portMAX_DELAY);
   int voltage = currentVoltage.get();
-  xSemaphoreGive(batteryMutex);
 
   // Safely get value
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   int threshold = settings->batteryAlarm.get();
-  xSemaphoreGive(settings->settingsMutex);
 
   if (voltage <= threshold && lastLowBatteryTime == 0) {
     lastLowBatteryTime = millis();
@@ -20,7 +20,7 @@ public:
   void updateBatteryVoltage();
   bool lowBattery();
 
-  VariableRestricted<int> currentVoltage;
+  AtomicVariableRestricted<int> currentVoltage;  // Atomic so reads don't need batteryMutex
 
   SemaphoreHandle_t batteryMutex;
 
@@ -1,7 +1,7 @@
 #include "buzzer.h"
 
 Buzzer::Buzzer(uint8_t p)
-  : pin(p), alarmHandle(NULL) {
+  : pin(p), toneOn(false), toneLevel(-1), clickTimer(NULL), clickPeriod(0), clickHigh(false), alarmHandle(NULL) {
 
   // Setup buzzer output pin
   pinMode(pin, OUTPUT);
@@ -12,11 +12,13 @@ Buzzer::Buzzer(uint8_t p)
 
 // Single buzz with programmed period
 void Buzzer::buzz() {
+  if (toneOn.load()) return;
   xTaskCreate(_buzz, "buzz", BUZZER_STACK_SIZE, this, 1, NULL);
 }
 
 // Double buzz with programmed period
 void Buzzer::doubleBuzz() {
+  if (toneOn.load()) return;
   xTaskCreate(_doubleBuzz, "buzz", BUZZER_STACK_SIZE, this, 1, NULL);
 }
 
@@ -40,6 +42,88 @@ void Buzzer::stopAlarm() {
   }
 }
 
+// Start continuous tone for finder, using LEDC PWM for passive buzzer and click timer for active buzzer
+// Other buzzing is skipped until stopped
+// Returns false if buzzer couldn't be driven
+bool Buzzer::startTone() {
+  if (toneOn.exchange(true)) return true;
+
+  toneLevel = -1;
+
+#ifdef PASSIVE_BUZZER
+  if (!ledcAttach(pin, PITCH_MIN_FREQUENCY, TONE_RESOLUTION)) {
+    toneOn.store(false);
+    return false;
+  }
+  setTone(0);
+#else
+  // Timer created on first use, as esp_timer isn't ready when constructed
+  if (clickTimer == NULL) {
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = _click;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "click";
+    if (esp_timer_create(&timerArgs, &clickTimer) != ESP_OK) {
+      clickTimer = NULL;
+      toneOn.store(false);
+      return false;
+    }
+  }
+
+  setTone(0);
+  clickHigh = false;
+  if (esp_timer_start_once(clickTimer, clickPeriod.load()) != ESP_OK) {
+    toneOn.store(false);
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+// Set tone from 0 (weakest) to TONE_LEVELS - 1 (strongest)
+// Only reconfigures PWM when level changes, so cheap to call every frame
+void Buzzer::setTone(int level) {
+  level = std::clamp(level, 0, TONE_LEVELS - 1);
+  if (!toneOn.load() || level == toneLevel) return;
+  toneLevel = level;
+
+#ifdef PASSIVE_BUZZER
+  // Square wave with pitch rising with level
+  // Silent if frequency can't be set, and tried again on next call
+  uint32_t frequency = PITCH_MIN_FREQUENCY + level * (PITCH_MAX_FREQUENCY - PITCH_MIN_FREQUENCY) / (TONE_LEVELS - 1);
+  if (ledcChangeFrequency(pin, frequency, TONE_RESOLUTION) == 0) {
+    ledcWrite(pin, 0);
+    toneLevel = -1;
+    return;
+  }
+  ledcWrite(pin, 1 << (TONE_RESOLUTION - 1));
+#else
+  // Active buzzer sounds while pin high, so short pulse once per period gives a click
+  // Picked up by click timer from next click
+  uint32_t rate = CLICK_MIN_RATE + level * (CLICK_MAX_RATE - CLICK_MIN_RATE) / (TONE_LEVELS - 1);
+  clickPeriod.store(1000000 / rate);
+#endif
+}
+
+// Stop finder tone and return pin to normal buzzing
+void Buzzer::stopTone() {
+  if (!toneOn.load()) return;
+
+#ifdef PASSIVE_BUZZER
+  ledcDetach(pin);
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  toneOn.store(false);
+#else
+  // Cleared first so a click already running doesn't restart timer
+  toneOn.store(false);
+  esp_timer_stop(clickTimer);
+  digitalWrite(pin, LOW);
+#endif
+}
+
 // Spawned in another thread to prevent blocking
 void Buzzer::_buzz(void *parameter) {
   // Static cast weirdness to access pin variable
@@ -72,6 +156,22 @@ void Buzzer::_doubleBuzz(void *parameter) {
   vTaskDelete(NULL);
 }
 
+// Click timer callback, alternates between CLICK_DURATION high and rest of period low
+void Buzzer::_click(void *parameter) {
+  Buzzer *buzzer = static_cast<Buzzer *>(parameter);
+
+  // Tone stopped while callback was due
+  if (!buzzer->toneOn.load()) {
+    digitalWrite(buzzer->pin, LOW);
+    return;
+  }
+
+  buzzer->clickHigh = !buzzer->clickHigh;
+  digitalWrite(buzzer->pin, buzzer->clickHigh ? HIGH : LOW);
+  uint32_t high = CLICK_DURATION * 1000;
+  esp_timer_start_once(buzzer->clickTimer, buzzer->clickHigh ? high : buzzer->clickPeriod.load() - high);
+}
+
 // Spawned in another thread to prevent blocking
 void Buzzer::_alarm(void *parameter) {
   // Static cast weirdness to access buzz()
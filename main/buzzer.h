@@ -2,12 +2,27 @@
 #define BUZZER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
 
 #define BUZZ_DURATION 20
 #define BUZZ_DELAY 80
 
 #define BUZZER_STACK_SIZE 512
 
+// Uncomment this line if using a passive buzzer
+// Finder tone then changes pitch with signal strength, rather than click rate
+// #define PASSIVE_BUZZER
+
+#define TONE_RESOLUTION 10     // LEDC duty resolution in bits, passive buzzer only
+#define TONE_LEVELS 16         // Steps tone changes between, limits how often PWM is reconfigured
+// Click rates are far below what LEDC can divide down to, so clicks are timed with esp_timer instead
+#define CLICK_MIN_RATE 2       // Clicks per second at weakest signal
+#define CLICK_MAX_RATE 30      // Clicks per second at strongest signal
+#define CLICK_DURATION 4       // ms
+#define PITCH_MIN_FREQUENCY 400   // Hz at weakest signal
+#define PITCH_MAX_FREQUENCY 4000  // Hz at strongest signal
+
 // Buzzer class for buzzer module
 class Buzzer {
 public:
@@ -16,14 +31,27 @@ public:
   void doubleBuzz();
   void startAlarm();
   void stopAlarm();
+  bool startTone();
+  void setTone(int level);
+  void stopTone();
 
 private:
   static void _buzz(void *parameter);
   static void _doubleBuzz(void *parameter);
   static void _alarm(void *parameter);
+  static void _click(void *parameter);
 
   uint8_t pin;
 
+  // Pin driven by LEDC or click timer while tone on, other buzzing skipped
+  std::atomic<bool> toneOn;
+  int toneLevel;
+
+  // Active buzzer clicks, pin toggled by one-shot timer so click length and period can differ
+  esp_timer_handle_t clickTimer;
+  std::atomic<uint32_t> clickPeriod;  // us
+  bool clickHigh;                     // Only used by timer callback
+
   TaskHandle_t alarmHandle;
 };
 
@@ -0,0 +1,112 @@
+#include "delta.h"
+
+DeltaEncoder::DeltaEncoder()
+  : threshold(DEFAULT_DELTA_THRESHOLD), generation(0), sinceKeyframe(0), keyframeRequested(false) {
+  plan = {};
+}
+
+// Write varint, 7 bits per byte with top bit set on all but last
+static size_t putVarint(uint8_t *out, uint32_t value) {
+  size_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  out[length++] = value;
+  return length;
+}
+
+// Encode sweep as keyframe or delta from last frame encoded
+// Keyframe sent when due, requested, frequencies or threshold changed, or changes would take more space than whole sweep
+// Returns length of frame written to out, capacity must be at least PACKED_MAX_SIZE
+size_t DeltaEncoder::encode(const Sweep *sweep, int settleTime, int changeThreshold, uint8_t *out, size_t capacity) {
+  bool keyframe = keyframeRequested.exchange(false) || generation == 0 || changeThreshold != threshold
+                  || sinceKeyframe >= DELTA_KEYFRAME_INTERVAL - 1 || !plan.sameFrequencies(sweep->plan);
+  threshold = changeThreshold;
+
+  if (!keyframe) {
+    size_t length = encodeDelta(sweep, out, std::min(capacity, packedSweepSize(sweep, 16)));
+    if (length > 0) {
+      generation = sweep->generation;
+      sinceKeyframe++;
+      return length;
+    }
+  }
+
+  PackedBuffer buffer(out, capacity);
+  writePackedSweep(buffer, sweep, LIVE, 16, settleTime);
+  for (int i = 0; i < sweep->plan.length; i++) {
+    sent[i] = sweep->values.get(i);
+  }
+  plan = sweep->plan;
+  generation = sweep->generation;
+  sinceKeyframe = 0;
+  return buffer.length();
+}
+
+// Write values that moved more than threshold from last sent
+// Returns 0 without updating sent values if frame would be maxLength or longer
+size_t DeltaEncoder::encodeDelta(const Sweep *sweep, uint8_t *out, size_t maxLength) {
+  uint8_t flags = PACKED_DELTA;
+  if (sweep->plan.lowband) flags |= PACKED_LOWBAND;
+  if (sweep->plan.mode == FOCUS) flags |= PACKED_FOCUS;
+  if (sweep->complete) flags |= PACKED_COMPLETE;
+  if (sweep->plan.mode == CHANNELS) flags |= PACKED_CHANNELS;
+
+  // Largest pair is 2 bytes each for a gap under 16384 and a 13 bit zigzag change
+  size_t length = DELTA_HEADER_SIZE;
+  int count = 0;
+  int previous = -1;
+  for (int i = 0; i < sweep->plan.length; i++) {
+    int change = sweep->values.get(i) - sent[i];
+    if (abs(change) <= threshold) continue;
+
+    if (length + 4 >= maxLength) return 0;
+    // Zigzag keeps small negative changes short
+    length += putVarint(&out[length], i - previous - 1);
+    length += putVarint(&out[length], ((uint32_t)change << 1) ^ (uint32_t)(change >> 31));
+    previous = i;
+    count++;
+  }
+
+  out[0] = PACKED_VERSION;
+  out[1] = flags;
+  out[2] = count & 0xFF;
+  out[3] = count >> 8;
+  for (int i = 0; i < 4; i++) {
+    out[4 + i] = (sweep->generation >> (8 * i)) & 0xFF;
+    out[8 + i] = (generation >> (8 * i)) & 0xFF;
+  }
+
+  // Frame fits, so clients will now hold these values
+  for (int i = 0; i < sweep->plan.length; i++) {
+    if (abs(sweep->values.get(i) - sent[i]) > threshold) sent[i] = sweep->values.get(i);
+  }
+  return length;
+}
+
+// Next frame encoded is a keyframe, used when a client joins
+// Safe to call from any task
+void DeltaEncoder::requestKeyframe() {
+  keyframeRequested.store(true);
+}
+
+// Encode as null terminated base64, out must hold BASE64_LENGTH(length) + 1 chars
+// Returns length of string
+size_t base64Encode(const uint8_t *data, size_t length, char *out) {
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  size_t used = 0;
+  for (size_t i = 0; i < length; i += 3) {
+    uint32_t group = data[i] << 16;
+    if (i + 1 < length) group |= data[i + 1] << 8;
+    if (i + 2 < length) group |= data[i + 2];
+
+    out[used++] = alphabet[(group >> 18) & 0x3F];
+    out[used++] = alphabet[(group >> 12) & 0x3F];
+    out[used++] = i + 1 < length ? alphabet[(group >> 6) & 0x3F] : '=';
+    out[used++] = i + 2 < length ? alphabet[group & 0x3F] : '=';
+  }
+  out[used] = '\0';
+  return used;
+}
@@ -0,0 +1,42 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <Arduino.h>
+#include "packed.h"
+#include "RX5808.h"
+
+// Sweeps streamed as full keyframes in packed.h format, with only changed values sent in between
+// Delta frames are a little-endian header, then a varint index gap and zigzag varint change for each value sent:
+//   0  version          uint8, same as keyframes
+//   1  flags            uint8, PACKED_DELTA always set
+//   2  count            uint16, number of values sent
+//   4  generation       uint32
+//   8  base generation  uint32, frame changes apply to, clients that don't hold it wait for next keyframe
+#define DELTA_HEADER_SIZE 12
+#define DELTA_KEYFRAME_INTERVAL 16   // Frames between keyframes, limits how long resynchronising takes
+
+// Base64 for carrying frames over text
+#define BASE64_LENGTH(bytes) (((bytes) + 2) / 3 * 4)
+
+// Keeps values clients were last sent, so each frame holds only changes since the one before
+// Only used by one task, except requestKeyframe()
+class DeltaEncoder {
+public:
+  DeltaEncoder();
+  size_t encode(const Sweep *sweep, int settleTime, int changeThreshold, uint8_t *out, size_t capacity);
+  void requestKeyframe();
+
+private:
+  size_t encodeDelta(const Sweep *sweep, uint8_t *out, size_t maxLength);
+
+  uint16_t sent[MAX_FREQUENCIES_SCANNED];  // Values as clients hold them, each within threshold of actual value
+  ScanPlan plan;
+  int threshold;        // Values within this many adc units of sent value aren't sent, from settings
+  uint32_t generation;  // Last frame encoded, 0 before first
+  int sinceKeyframe;    // Delta frames since last keyframe
+  std::atomic<bool> keyframeRequested;
+};
+
+size_t base64Encode(const uint8_t *data, size_t length, char *out);
+
+#endif
@@ -0,0 +1,83 @@
+#include "history.h"
+
+SweepHistory::SweepHistory()
+  : capacity(0), next(0), count(0) {
+  plan = {};
+  historyMutex = xSemaphoreCreateMutex();
+}
+
+// Quantise and store complete sweep, overwriting oldest once full
+// Called by scanning task after publishing, so values don't change while running
+void SweepHistory::add(const ScanPlan &sweepPlan, const VariableBufferRestricted<uint16_t> &values, uint32_t generation, unsigned long timestamp) {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+
+  // Readings from different frequencies can't be compared, so start again
+  if (count == 0 || !plan.sameFrequencies(sweepPlan)) {
+    plan = sweepPlan;
+    capacity = std::min(HISTORY_MAX_SWEEPS, HISTORY_BYTES / plan.length);
+    next = 0;
+    count = 0;
+  }
+
+  uint8_t *slot = &readings[next * plan.length];
+  for (int i = 0; i < plan.length; i++) {
+    slot[i] = values.get(i) >> HISTORY_SHIFT;
+  }
+  records[next] = { generation, timestamp };
+
+  next = (next + 1) % capacity;
+  count = std::min(count + 1, capacity);
+
+  xSemaphoreGive(historyMutex);
+}
+
+// Copy sweeps published between from and to inclusive in ms, oldest first
+// Stops at maxRecords sweeps or maxBytes of readings, with more set if sweeps in range were left out
+// Returns number of sweeps copied, each plan.length readings long
+int SweepHistory::copy(unsigned long from, unsigned long to, HistoryRecord *copiedRecords, int maxRecords, uint8_t *values, int maxBytes, ScanPlan &copiedPlan, bool &more) {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+
+  copiedPlan = plan;
+  more = false;
+  int copied = 0;
+  for (int i = 0; i < count; i++) {
+    int index = (next - count + i + capacity) % capacity;
+    if (records[index].timestamp < from) continue;
+    if (records[index].timestamp > to) break;
+
+    if (copied >= maxRecords || (copied + 1) * plan.length > maxBytes) {
+      more = true;
+      break;
+    }
+
+    memcpy(&values[copied * plan.length], &readings[index * plan.length], plan.length);
+    copiedRecords[copied++] = records[index];
+  }
+
+  xSemaphoreGive(historyMutex);
+  return copied;
+}
+
+// Copy most recent sweeps newest first, each downsampled to at most maxColumns
+// Each column is strongest reading it covers, same as scan graph
+// Returns number of rows copied, each columns long
+int SweepHistory::copyWaterfall(uint8_t *rows, int maxRows, int maxColumns, int &columns, ScanPlan &copiedPlan) {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+
+  copiedPlan = plan;
+  columns = std::min(plan.length, maxColumns);
+  int copied = std::min(count, maxRows);
+  for (int row = 0; row < copied; row++) {
+    const uint8_t *slot = &readings[((next - 1 - row + capacity) % capacity) * plan.length];
+    for (int column = 0; column < columns; column++) {
+      uint8_t strongest = 0;
+      for (int i = column * plan.length / columns; i < (column + 1) * plan.length / columns; i++) {
+        strongest = std::max(strongest, slot[i]);
+      }
+      rows[row * columns + column] = strongest;
+    }
+  }
+
+  xSemaphoreGive(historyMutex);
+  return copied;
+}
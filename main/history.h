@@ -0,0 +1,43 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "scanplan.h"
+#include "variable.h"
+
+// Readings are quantised to 8 bits, so number of sweeps kept depends on sweep length
+#define HISTORY_BYTES 32768      // Space for quantised readings, 512 sweeps of 5MHz interval
+#define HISTORY_MAX_SWEEPS 512
+#define HISTORY_SHIFT 4          // 12 bit adc readings shifted down to fit in 8 bits
+
+// Most history copied into one api or usb response
+#define HISTORY_RESPONSE_SWEEPS 64
+#define HISTORY_RESPONSE_BYTES 4096
+
+// Complete sweep kept in history
+struct HistoryRecord {
+  uint32_t generation;
+  unsigned long timestamp;  // Time sweep published in ms
+};
+
+// Ring buffer of recent complete sweeps with readings quantised to 8 bits
+// Only holds sweeps of one scan plan, cleared when frequencies scanned change
+class SweepHistory {
+public:
+  SweepHistory();
+  void add(const ScanPlan &plan, const VariableBufferRestricted<uint16_t> &values, uint32_t generation, unsigned long timestamp);
+  int copy(unsigned long from, unsigned long to, HistoryRecord *records, int maxRecords, uint8_t *values, int maxBytes, ScanPlan &plan, bool &more);
+  int copyWaterfall(uint8_t *rows, int maxRows, int maxColumns, int &columns, ScanPlan &plan);
+
+private:
+  uint8_t readings[HISTORY_BYTES];  // Slot i starts at i * plan.length
+  HistoryRecord records[HISTORY_MAX_SWEEPS];
+  ScanPlan plan;  // Frequencies of every sweep kept
+  int capacity;   // Sweeps that fit for current plan
+  int next;       // Slot written next
+  int count;      // Sweeps kept, oldest overwritten once full
+
+  SemaphoreHandle_t historyMutex;
+};
+
+#endif
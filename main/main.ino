@@ -15,8 +15,35 @@ Settings settings;
 // Create buzzer object
 Buzzer buzzer(BUZZER_PIN);
 
+// Create register transport for each RX5808
+// Swap for GpioTransport or SpiTransport to change how registers are sent, retune times are reported in stats
+RegisterTransport *transports[] = {
+  new FastGpioTransport(SPI_DATA_PIN, SPI_LE_PIN, SPI_CLK_PIN),
+#if RX5808_MODULES > 1
+  new FastGpioTransport(SPI_DATA_PIN, SPI_LE_PIN_2, SPI_CLK_PIN),
+#endif
+#if RX5808_MODULES > 2
+  new FastGpioTransport(SPI_DATA_PIN, SPI_LE_PIN_3, SPI_CLK_PIN),
+#endif
+#if RX5808_MODULES > 3
+  new FastGpioTransport(SPI_DATA_PIN, SPI_LE_PIN_4, SPI_CLK_PIN),
+#endif
+};
+const uint8_t rssiPins[] = {
+  RSSI_PIN,
+#if RX5808_MODULES > 1
+  RSSI_PIN_2,
+#endif
+#if RX5808_MODULES > 2
+  RSSI_PIN_3,
+#endif
+#if RX5808_MODULES > 3
+  RSSI_PIN_4,
+#endif
+};
+
 // Create RX5808 object
-RX5808 receiver(SPI_DATA_PIN, SPI_LE_PIN, SPI_CLK_PIN, RSSI_PIN, &settings);
+RX5808 receiver(transports, rssiPins, RX5808_MODULES, &settings);
 
 #ifdef BATTERY_MONITORING
 // Create battery object
@@ -49,6 +76,9 @@ void setup() {
   // Load settings from non-volatile memory
   settings.loadSettingsStorage();
 
+  // Setup receiver
+  receiver.begin();
+
   // Setup menu
   menu.begin();
 
@@ -80,9 +110,7 @@ void loop() {
 
 #ifdef BATTERY_MONITORING
   // Draw battery voltage
-  xSemaphoreTake(battery.batteryMutex, portMAX_DELAY);
   menu.drawBatteryVoltage(battery.currentVoltage.get());
-  xSemaphoreGive(battery.batteryMutex);
 #endif
 
   // Send display buffer
@@ -7,7 +7,7 @@ Menu *Menu::instance = nullptr;
 Menu::Menu(uint8_t p_p, uint8_t s_p, uint8_t n_p, Settings *s, Buzzer *b, RX5808 *r, Api *a, UsbSerial *u)
   : menuIndex(MAIN),
     previous_pin(p_p), select_pin(s_p), next_pin(n_p),
-    selectButtonPressTime(0), selectButtonHeld(false),
+    selectButtonPressTime(0), selectButtonHeld(false), bandButtonsHeld(false), focusReturnIndex(0), finderMuted(false),
     settings(s), buzzer(b), receiver(r), api(a), usb(u),
     u8g2(U8G2_R0, U8X8_PIN_NONE) {
   instance = this;  // Set static instance pointer
@@ -62,24 +62,30 @@ void Menu::doEncoder() {
 // Handle navigation between menus
 // Manipulates the internal menuIndex variable
 void Menu::handleButtons() {
-  // Update length of scan menu
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
-  menus[SCAN].menuItemsLength = (SCAN_FREQUENCY_RANGE / settings->scanInterval.get()) + 1;  // +1 for final number inclusion
-  xSemaphoreGive(settings->settingsMutex);
+  // Update length of scan menu to match frequencies in latest sweep
+  const Sweep *sweep = receiver->borrowSweep();
+  menus[SCAN].menuItemsLength = std::max(sweep->plan.length, 1);
+  receiver->returnSweep(sweep);
 
 #ifdef ROTARY_ENCODER_INPUT
   int selectPressed = !digitalRead(select_pin);
   if (dial_pos != last_dial_pos) {
     if (selectPressed == HIGH) {
       if ((dial_pos - 4) > last_dial_pos) settings->clearReset();  // Reset is pressed and rotated anti-clockwise
+
+      // Toggle band if pressed and rotated clockwise on scan menu
+      // Counts as held so releasing SELECT doesn't also toggle focus
+      if (menuIndex == SCAN && (dial_pos + 4) < last_dial_pos) {
+        toggleBand();
+        selectButtonHeld = true;
+        last_dial_pos = dial_pos;
+      }
     } else {
       // Move through menu
       menus[menuIndex].menuIndex = (menus[menuIndex].menuIndex + (last_dial_pos - dial_pos) + menus[menuIndex].menuItemsLength) % menus[menuIndex].menuItemsLength;
 
       // Sound buzzer if necessary
-      xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
       if (settings->buzzer.get()) buzzer->buzz();
-      xSemaphoreGive(settings->settingsMutex);
 
       last_dial_pos = dial_pos;
     }
@@ -94,15 +100,29 @@ void Menu::handleButtons() {
     settings->clearReset();
   }
 
+  // Pressing PREV and NEXT together on scan menu toggles between high and low band
+  if (menuIndex == SCAN && prevPressed == HIGH && nextPressed == HIGH) {
+    if (!bandButtonsHeld) {
+      toggleBand();
+      bandButtonsHeld = true;
+
+      // Sound buzzer on button press if necessary
+      if (settings->buzzer.get()) buzzer->buzz();
+    }
+
+    // Delay for button debouncing
+    delay(DEBOUNCE_DELAY);
+    return;
+  }
+  bandButtonsHeld = false;
+
   // Move between menu items
   if (nextPressed == HIGH || prevPressed == HIGH) {
     int direction = (nextPressed == HIGH) ? 1 : -1;
     menus[menuIndex].menuIndex = (menus[menuIndex].menuIndex + direction + menus[menuIndex].menuItemsLength) % menus[menuIndex].menuItemsLength;
 
     // Sound buzzer on button press if necessary
-    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
     if (settings->buzzer.get()) buzzer->buzz();
-    xSemaphoreGive(settings->settingsMutex);
 
     // Delay for button debouncing
     delay(DEBOUNCE_DELAY);
@@ -115,23 +135,23 @@ void Menu::handleButtons() {
       selectButtonPressTime = millis();
 
       // Sound buzzer on button press if necessary
-      xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
       if (settings->buzzer.get()) buzzer->buzz();
-      xSemaphoreGive(settings->settingsMutex);
     } else if (!selectButtonHeld && millis() - selectButtonPressTime > LONG_PRESS_DURATION) {  // Held longer than threshold register long press
       switch (menuIndex) {
         case MAIN: menuIndex = ADVANCED; break;                             // If on main menu, go to advanced
         case SCAN_INTERVAL ... BATTERY_ALARM: menuIndex = SETTINGS; break;  // If on individual settings menu, go to settings
-        case CALIBRATION ... USB_SERIAL: menuIndex = ADVANCED; break;       // If on individual advanced menu, go to advanced
+        case WIFI ... USB_SERIAL: setFinder(0); menuIndex = ADVANCED; break;  // If on remote menu, stop any finder started through it and go to advanced
+        case CALIBRATION:
+        case AUTO_TUNE: menuIndex = ADVANCED; break;                        // If on other individual advanced menu, go to advanced
+        case SCAN: setFocus(0); menuIndex = MAIN; break;                    // If on scan menu, leave focus and go to main
+        case FINDER: setFinder(0); menuIndex = MAIN; break;                 // If on finder menu, stop finder and go to main
         default: menuIndex = MAIN; break;                                   // Otherwise, go back to main menu
       }
 
       selectButtonHeld = true;
 
       // Sound double buzz on back if necessary
-      xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
       if (settings->buzzer.get()) buzzer->doubleBuzz();
-      xSemaphoreGive(settings->settingsMutex);
     }
 
     // Delay for button debouncing
@@ -146,21 +166,54 @@ void Menu::handleButtons() {
     switch (menuIndex) {
       case MAIN:  // Handle SELECT on main menu
         switch (menus[MAIN].menuIndex) {
-          case 0: menuIndex = SCAN; break;      // Go to scan menu
-          case 1: menuIndex = SETTINGS; break;  // Go to settings menu
-          case 2: menuIndex = ABOUT; break;     // Go to about menu
+          case 0: menuIndex = SCAN; break;  // Go to scan menu
+          case 1:                           // Go to finder menu, starting on frequency selected in scan menu
+            {
+              const Sweep *sweep = receiver->borrowSweep();
+              int frequency = sweep->plan.frequency(std::min(menus[SCAN].menuIndex, sweep->plan.length - 1));
+              receiver->returnSweep(sweep);
+              menus[FINDER].menuIndex = frequency - RX5808_MIN_FREQUENCY;
+              menuIndex = FINDER;
+              break;
+            }
+          case 2: menuIndex = PEAKS; break;      // Go to peaks menu
+          case 3: menuIndex = WATERFALL; break;  // Go to waterfall menu
+          case 4: menuIndex = SETTINGS; break;   // Go to settings menu
+          case 5: menuIndex = ABOUT; break;      // Go to about menu
         }
         break;
       case SCAN:  // Handle SELECT on scan menu
-        xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-        receiver->lowband.set(!receiver->lowband.get());
-        xSemaphoreGive(receiver->lowbandMutex);
+        if (receiver->focusFrequency.get() != 0) {
+          // Return to full sweep with cursor where it was before focusing
+          setFocus(0);
+          menus[SCAN].menuIndex = focusReturnIndex;
+        } else {
+          // Focus on selected frequency, moving cursor to it within window
+          const Sweep *sweep = receiver->borrowSweep();
+          int frequency = sweep->plan.frequency(std::min(menus[SCAN].menuIndex, sweep->plan.length - 1));
+          receiver->returnSweep(sweep);
+
+          focusReturnIndex = menus[SCAN].menuIndex;
+          setFocus(frequency);
+          menus[SCAN].menuIndex = frequency - focusMinFrequency(frequency);
+        }
+        break;
+      case FINDER:  // Mute or unmute finder tone
+        finderMuted = !finderMuted;
+        break;
+      case PEAKS:  // Open finder on selected peak
+        if (peakList.length > 0) {
+          menus[FINDER].menuIndex = peakList.peaks[menus[PEAKS].menuIndex].frequency - RX5808_MIN_FREQUENCY;
+          menuIndex = FINDER;
+        }
         break;
       case SETTINGS:  // Handle SELECT on settings menu
         switch (menus[SETTINGS].menuIndex) {
           case 0: menuIndex = SCAN_INTERVAL; break;  // Go to scan interval menu
-          case 1: menuIndex = BUZZER; break;         // Go to buzzer menu
-          case 2: menuIndex = BATTERY_ALARM; break;  // Go to battery alarm menu
+          case 1: menuIndex = SWEEP_ORDER; break;    // Go to sweep order menu
+          case 2: menuIndex = TRACE; break;          // Go to trace menu
+          case 3: menuIndex = BUZZER; break;         // Go to buzzer menu
+          case 4: menuIndex = BATTERY_ALARM; break;  // Go to battery alarm menu
         }
         break;
       case ADVANCED:  // Handle SELECT on advanced menu
@@ -168,6 +221,7 @@ void Menu::handleButtons() {
           case 0: menuIndex = CALIBRATION; break;  // Go to calibration menu
           case 1: menuIndex = WIFI; break;         // Go to Wi-Fi menu
           case 2: menuIndex = USB_SERIAL; break;   // Go to serial menu
+          case 3: menuIndex = AUTO_TUNE; break;    // Go to auto-tune menu
         }
         break;
       case SCAN_INTERVAL ... BATTERY_ALARM:  // Handle SELECT on individual settings options
@@ -176,8 +230,21 @@ void Menu::handleButtons() {
             xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
             settings->scanIntervalIndex.set(menus[SCAN_INTERVAL].menuIndex);
             xSemaphoreGive(settings->settingsMutex);
+            setFocus(0);
             menus[SCAN].menuIndex = 0;
             break;
+          case SWEEP_ORDER:  // Update sweep order setting
+            xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+            settings->sweepOrderIndex.set(menus[SWEEP_ORDER].menuIndex);
+            xSemaphoreGive(settings->settingsMutex);
+            receiver->reconfigure();
+            break;
+          case TRACE:  // Update trace setting, selecting current trace restarts it
+            xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+            settings->traceIndex.set(menus[TRACE].menuIndex);
+            xSemaphoreGive(settings->settingsMutex);
+            receiver->resetTraces();
+            break;
           case BUZZER:  // Update buzzer setting
             xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
             settings->buzzerIndex.set(menus[BUZZER].menuIndex);
@@ -192,10 +259,13 @@ void Menu::handleButtons() {
         break;
       case CALIBRATION:  // Handle SELECT on calibration menu
         switch (menus[CALIBRATION].menuIndex) {
-          case 0: receiver->calibrate(true); break;   // Calibrate high rssi
-          case 1: receiver->calibrate(false); break;  // Calibrate low rssi
+          case 0: receiver->requestCalibration(true); break;   // Calibrate high rssi
+          case 1: receiver->requestCalibration(false); break;  // Calibrate low rssi
         }
         break;
+      case AUTO_TUNE:  // Start auto-tune if not already running
+        if (!receiver->autoTuning.get()) receiver->requestAutoTune();
+        break;
     }
   }
 
@@ -204,6 +274,30 @@ void Menu::handleButtons() {
   selectButtonHeld = false;
 }
 
+// Switch between scanning high and low band
+void Menu::toggleBand() {
+  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+  receiver->lowband.set(!receiver->lowband.get());
+  xSemaphoreGive(receiver->lowbandMutex);
+  receiver->reconfigure();
+}
+
+// Focus scanning on window around frequency, or return to full sweep with 0
+void Menu::setFocus(int frequency) {
+  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+  receiver->focusFrequency.set(frequency);
+  xSemaphoreGive(receiver->lowbandMutex);
+  receiver->reconfigure();
+}
+
+// Sample single frequency continuously, or return to sweeping with 0
+void Menu::setFinder(int frequency) {
+  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+  receiver->finderFrequency.set(frequency);
+  xSemaphoreGive(receiver->lowbandMutex);
+  receiver->reconfigure();
+}
+
 // Clear display buffer
 void Menu::clearBuffer() {
   u8g2.clearBuffer();
@@ -216,8 +310,8 @@ void Menu::sendBuffer() {
 
 // Draw current menu
 void Menu::drawMenu() {
-  // Draw title, but not for scan menu
-  if (menuIndex != SCAN) {
+  // Draw title, but not for scan or finder menus
+  if (menuIndex != SCAN && menuIndex != FINDER) {
     u8g2.setFont(u8g2_font_8x13B_tf);
     const char *title = menus[menuIndex].title;
     u8g2.drawStr(textCentreX(title, 8), 13, title);
@@ -226,13 +320,16 @@ void Menu::drawMenu() {
 
   // Update in-memory icons for individual settings options
   if (menuIndex >= SCAN_INTERVAL && menuIndex <= BATTERY_ALARM) {
-    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
     updateSettingsOptionIcons(&menus[SCAN_INTERVAL], settings->scanIntervalIndex.get());
+    updateSettingsOptionIcons(&menus[SWEEP_ORDER], settings->sweepOrderIndex.get());
+    updateSettingsOptionIcons(&menus[TRACE], settings->traceIndex.get());
     updateSettingsOptionIcons(&menus[BUZZER], settings->buzzerIndex.get());
     updateSettingsOptionIcons(&menus[BATTERY_ALARM], settings->batteryAlarmIndex.get());
-    xSemaphoreGive(settings->settingsMutex);
   }
 
+  // Finder tone only plays on finder menu
+  if (menuIndex != FINDER) buzzer->stopTone();
+
   // Call appropriate draw function
   switch (menuIndex) {
     case SCAN:  // Draw scan menu
@@ -242,9 +339,25 @@ void Menu::drawMenu() {
     case ABOUT:  // Draw about menu
       drawAboutMenu();
       break;
+    case PEAKS:  // Draw list of peaks found while scanning
+      receiver->startScan();
+      drawPeaksMenu();
+      break;
+    case WATERFALL:  // Draw history of recent sweeps
+      receiver->startScan();
+      drawWaterfallMenu();
+      break;
+    case FINDER:  // Draw finder menu, retuning if frequency changed
+      if (receiver->finderFrequency.get() != RX5808_MIN_FREQUENCY + menus[FINDER].menuIndex) {
+        setFinder(RX5808_MIN_FREQUENCY + menus[FINDER].menuIndex);
+      }
+      receiver->startScan();
+      drawFinderMenu();
+      break;
     case WIFI:  // Draw Wi-Fi menu
       receiver->startScan();
       api->startWifi();
+      api->pushSweeps();
       drawWifiMenu();
       break;
     case USB_SERIAL:  // Draw serial menu
@@ -252,6 +365,10 @@ void Menu::drawMenu() {
       usb->listen();
       drawSerialMenu();
       break;
+    case AUTO_TUNE:  // Draw auto-tune menu
+      receiver->stopScan();
+      drawAutoTuneMenu();
+      break;
     default:  // Draw selection menu with options
       receiver->stopScan();
       api->stopWifi();
@@ -270,7 +387,7 @@ void Menu::drawBatteryVoltage(int voltage) {
     snprintf(formattedVoltage, sizeof(formattedVoltage), "%d.%dv", voltage / 10, voltage % 10);
 
     // Set font colour to inverted if selected bottom item
-    u8g2.setDrawColor(menus[MAIN].menuIndex == 2 ? 0 : 1);
+    u8g2.setDrawColor(menus[MAIN].menuIndex >= VISIBLE_MENU_ITEMS - 1 ? 0 : 1);
     u8g2.setFont(u8g2_font_5x7_tf);
     u8g2.drawStr(109, DISPLAY_HEIGHT, formattedVoltage);
     u8g2.setDrawColor(1);
@@ -279,91 +396,112 @@ void Menu::drawBatteryVoltage(int voltage) {
 
 // Generic function for drawing menus with multiple options
 void Menu::drawSelectionMenu() {
+  // Scroll so selection is always on screen
+  int first = std::max(0, menus[menuIndex].menuIndex - (VISIBLE_MENU_ITEMS - 1));
+  int last = std::min(menus[menuIndex].menuItemsLength, first + VISIBLE_MENU_ITEMS);
+
   // Draw menu items
-  for (int i = 0; i < menus[menuIndex].menuItemsLength; i++) {
+  for (int i = first; i < last; i++) {
+    int row = i - first;
     if (i == menus[menuIndex].menuIndex) {
       // Highlight selection
-      u8g2.drawBox(0, 16 + (i * 16), DISPLAY_WIDTH, 16);
+      u8g2.drawBox(0, 16 + (row * 16), DISPLAY_WIDTH, 16);
       u8g2.setDrawColor(0);
-      u8g2.drawXBMP(10, 17 + (i * 16), 14, 14, menus[menuIndex].menuItems[i].icon);
-      u8g2.drawStr(30, 28 + (i * 16), menus[menuIndex].menuItems[i].name);
+      u8g2.drawXBMP(10, 17 + (row * 16), 14, 14, menus[menuIndex].menuItems[i].icon);
+      u8g2.drawStr(30, 28 + (row * 16), menus[menuIndex].menuItems[i].name);
       u8g2.setDrawColor(1);
     } else {
-      u8g2.drawXBMP(10, 17 + (i * 16), 14, 14, menus[menuIndex].menuItems[i].icon);
-      u8g2.drawStr(30, 28 + (i * 16), menus[menuIndex].menuItems[i].name);
+      u8g2.drawXBMP(10, 17 + (row * 16), 14, 14, menus[menuIndex].menuItems[i].icon);
+      u8g2.drawStr(30, 28 + (row * 16), menus[menuIndex].menuItems[i].name);
     }
   }
 
-  // Draw extra text for calibration menu
+  // Draw extra text for calibration menu, calibration runs in background so show progress
   if (menuIndex == CALIBRATION) {
     u8g2.setFont(u8g2_font_5x7_tf);
     const char *text = "Set to 5800MHz (F4)";
+    if (receiver->isCalibrating()) text = "Calibrating...";
+    else if (receiver->autoTuning.get()) text = "Wait for auto-tune";
     u8g2.drawStr(textCentreX(text, 5), 60, text);
   }
 }
 
 // Draw graph of scanned rssi values
 void Menu::drawScanMenu() {
-  // Calculate number of scanned values based off of interval
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
-  float interval = settings->scanInterval.get();
-  xSemaphoreGive(settings->settingsMutex);
-  int numScannedValues = (SCAN_FREQUENCY_RANGE / interval) + 1;  // +1 for final number inclusion
+  // Borrow latest complete sweep so graph and labels are from the same pass
+  const Sweep *sweep = receiver->borrowSweep();
+
+  // Nothing to draw until first sweep complete
+  if (sweep->generation == 0) {
+    receiver->returnSweep(sweep);
+
+    const char *text = "Scanning...";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+    return;
+  }
+
+  const ScanPlan &plan = sweep->plan;
+  int numScannedValues = plan.length;
+
+  // Cursor may be past end of sweep scanned before interval changed
+  int selected = std::min(menus[SCAN].menuIndex, numScannedValues - 1);
+
+  // More values than pixels are downsampled, with each column showing strongest value it covers
+  int numColumns = std::min(numScannedValues, DISPLAY_WIDTH);
+  int selectedColumn = selected * numColumns / numScannedValues;
 
   // Calculate width of each bar in graph by expanding until best fit
   int barWidth = 1;
-  while ((barWidth + 1) * numScannedValues <= DISPLAY_WIDTH) {
+  while ((barWidth + 1) * numColumns <= DISPLAY_WIDTH) {
     barWidth++;
   }
 
   // Calculate side padding offset for graph
-  int padding = (int)floor((DISPLAY_WIDTH - (barWidth * numScannedValues)) / 2);
+  int padding = (int)floor((DISPLAY_WIDTH - (barWidth * numColumns)) / 2);
 
   // Get min and max calibrated rssi
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   int minRssi = settings->lowCalibratedRssi.get();
   int maxRssi = settings->highCalibratedRssi.get();
-  xSemaphoreGive(settings->settingsMutex);
 
-  // Safely get lowband state
-  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-  bool lowband = receiver->lowband.get();
-  xSemaphoreGive(receiver->lowbandMutex);
+  // Graph and percentage show selected trace
+  TraceMode trace = (TraceMode)settings->traceIndex.get();
 
   // Draw bottom numbers
+  char frequencyLabel[5];
   u8g2.setFont(u8g2_font_5x7_tf);
-  if (lowband) {
-    u8g2.drawStr(0, DISPLAY_HEIGHT, "5345");
-    u8g2.drawStr(55, DISPLAY_HEIGHT, "5495");
-    u8g2.drawStr(109, DISPLAY_HEIGHT, "5645");
-  } else {
-    u8g2.drawStr(0, DISPLAY_HEIGHT, "5645");
-    u8g2.drawStr(55, DISPLAY_HEIGHT, "5795");
-    u8g2.drawStr(109, DISPLAY_HEIGHT, "5945");
+  snprintf(frequencyLabel, sizeof(frequencyLabel), "%d", plan.minFrequency);
+  u8g2.drawStr(0, DISPLAY_HEIGHT, frequencyLabel);
+  snprintf(frequencyLabel, sizeof(frequencyLabel), "%d", plan.frequency(plan.length / 2));
+  u8g2.drawStr(55, DISPLAY_HEIGHT, frequencyLabel);
+  snprintf(frequencyLabel, sizeof(frequencyLabel), "%d", plan.maxFrequency);
+  u8g2.drawStr(109, DISPLAY_HEIGHT, frequencyLabel);
+
+  // Draw trace between frequencies, nothing drawn for live readings
+  switch (trace) {
+    case MAX_HOLD: u8g2.drawStr(30, DISPLAY_HEIGHT, "MAX"); break;
+    case MIN_HOLD: u8g2.drawStr(30, DISPLAY_HEIGHT, "MIN"); break;
+    case AVERAGE: u8g2.drawStr(30, DISPLAY_HEIGHT, "AVG"); break;
+    default: break;
   }
 
-  // Draw high or low band
+  // Draw selected channel name, high or low band, or focus
+  // Nothing drawn for custom range as it isn't tied to a band
   u8g2.setFont(u8g2_font_7x13_tf);
-  if (lowband) {
-    u8g2.drawStr(0, 13, "LOW");
-  } else {
-    u8g2.drawStr(0, 13, "HIGH");
+  if (plan.mode == CHANNELS) {
+    u8g2.drawStr(0, 13, plan.channel(selected));
+  } else if (plan.mode == BAND) {
+    u8g2.drawStr(0, 13, plan.lowband ? "LOW" : "HIGH");
+  } else if (plan.mode == FOCUS) {
+    u8g2.drawStr(0, 13, "FOCUS");
   }
 
   // Draw selected frequency
   char currentFrequency[8];
-  int min_freq = lowband ? LOWBAND_MIN_FREQUENCY : HIGHBAND_MIN_FREQUENCY;
-  snprintf(currentFrequency, sizeof(currentFrequency), "%dMHz", (int)round(menus[SCAN].menuIndex * interval + min_freq));
+  snprintf(currentFrequency, sizeof(currentFrequency), "%dMHz", plan.frequency(selected));
   u8g2.drawStr(textCentreX(currentFrequency, 7), 13, currentFrequency);
 
-  // Safely get current rssi
-  int currentFrequencyRssi;
-  xSemaphoreTake(receiver->scanMutex, portMAX_DELAY);
-  currentFrequencyRssi = receiver->rssiValues.get(menus[SCAN].menuIndex);
-  xSemaphoreGive(receiver->scanMutex);
-
   // Clamp and convert rssi to percentage
-  currentFrequencyRssi = std::clamp(currentFrequencyRssi, minRssi, maxRssi);
+  int currentFrequencyRssi = std::clamp((int)sweep->trace(trace, selected), minRssi, maxRssi);
   char percentageStr[5];
   snprintf(percentageStr, sizeof(percentageStr), "%d%%", map(currentFrequencyRssi, minRssi, maxRssi, 0, 100));
 
@@ -371,31 +509,201 @@ void Menu::drawScanMenu() {
   int percentageX = DISPLAY_WIDTH - (strlen(percentageStr) * 7) + 1;
   u8g2.drawStr(percentageX, 13, percentageStr);
 
-  // Iterate through rssi values
-  for (int i = 0; i < numScannedValues; i++) {
-    // Safely get current rssi
-    int rssi;
-    xSemaphoreTake(receiver->scanMutex, portMAX_DELAY);
-    rssi = receiver->rssiValues.get(i);
-    xSemaphoreGive(receiver->scanMutex);
+  // Iterate through graph columns
+  for (int column = 0; column < numColumns; column++) {
+    // Strongest value of those covered by column
+    int first = column * numScannedValues / numColumns;
+    int last = (column + 1) * numScannedValues / numColumns;
+    int strongest = 0;
+    for (int i = first; i < last; i++) {
+      strongest = std::max(strongest, (int)sweep->trace(trace, i));
+    }
 
     // Clamp rssi between calibrated values
-    rssi = std::clamp(rssi, minRssi, maxRssi);
+    int rssi = std::clamp(strongest, minRssi, maxRssi);
 
     // Calculate height of individual bar
     int barHeight = map(rssi, minRssi, maxRssi, 0, BAR_Y_MAX - BAR_Y_MIN);
 
     // Draw box with x-offset
     // Highlight selection
-    if (i == menus[SCAN].menuIndex) {
-      u8g2.drawBox(i * barWidth + padding, BAR_Y_MIN, barWidth, BAR_Y_MAX - BAR_Y_MIN);
+    if (column == selectedColumn) {
+      u8g2.drawBox(column * barWidth + padding, BAR_Y_MIN, barWidth, BAR_Y_MAX - BAR_Y_MIN);
+      u8g2.setDrawColor(0);
+      u8g2.drawBox(column * barWidth + padding, BAR_Y_MAX - barHeight, barWidth, barHeight);
+      u8g2.setDrawColor(1);
+    } else {
+      u8g2.drawBox(column * barWidth + padding, BAR_Y_MAX - barHeight, barWidth, barHeight);
+    }
+  }
+
+  receiver->returnSweep(sweep);
+}
+
+// Draw scrolling trace of finder readings, newest on right
+// Also sets finder tone from latest reading
+void Menu::drawFinderMenu() {
+  int frequency = RX5808_MIN_FREQUENCY + menus[FINDER].menuIndex;
+
+  // Get min and max calibrated rssi
+  int minRssi = settings->lowCalibratedRssi.get();
+  int maxRssi = settings->highCalibratedRssi.get();
+
+  uint32_t first;
+  int length = receiver->getFinderTrace(finderTrace, FINDER_TRACE_LENGTH, 0, first);
+
+  // Nothing to draw until first reading at frequency
+  if (length == 0) {
+    buzzer->stopTone();
+
+    const char *text = "Tuning...";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+    return;
+  }
+
+  // Pitch or click rate follows latest reading, silent if muted here or buzzer turned off in settings
+  int rssi = std::clamp(receiver->finderRssi.get(), minRssi, maxRssi);
+  if (finderMuted || !settings->buzzer.get()) {
+    buzzer->stopTone();
+  } else {
+    buzzer->startTone();
+    buzzer->setTone(map(rssi, minRssi, maxRssi, 0, TONE_LEVELS - 1));
+  }
+
+  // Draw mute state
+  u8g2.setFont(u8g2_font_7x13_tf);
+  if (finderMuted) u8g2.drawStr(0, 13, "MUTE");
+
+  // Draw frequency
+  char currentFrequency[8];
+  snprintf(currentFrequency, sizeof(currentFrequency), "%dMHz", frequency);
+  u8g2.drawStr(textCentreX(currentFrequency, 7), 13, currentFrequency);
+
+  // Draw rssi percentage accounting for changes from 3 to 4 characters
+  char percentageStr[5];
+  snprintf(percentageStr, sizeof(percentageStr), "%d%%", (int)map(rssi, minRssi, maxRssi, 0, 100));
+  int percentageX = DISPLAY_WIDTH - (strlen(percentageStr) * 7) + 1;
+  u8g2.drawStr(percentageX, 13, percentageStr);
+
+  // Each column shows strongest of the readings it covers, right aligned so trace scrolls left
+  int numColumns = length / FINDER_TRACE_DECIMATION;
+  for (int column = 0; column < numColumns; column++) {
+    int strongest = 0;
+    for (int i = column * FINDER_TRACE_DECIMATION; i < (column + 1) * FINDER_TRACE_DECIMATION; i++) {
+      strongest = std::max(strongest, (int)finderTrace[i]);
+    }
+
+    int barHeight = map(std::clamp(strongest, minRssi, maxRssi), minRssi, maxRssi, 0, BAR_Y_MAX - BAR_Y_MIN);
+    u8g2.drawVLine(DISPLAY_WIDTH - numColumns + column, BAR_Y_MAX - barHeight, barHeight);
+  }
+
+  u8g2.setFont(u8g2_font_5x7_tf);
+  const char *text = finderMuted ? "Press SEL to unmute" : "Press SEL to mute";
+  u8g2.drawStr(textCentreX(text, 5), DISPLAY_HEIGHT, text);
+}
+
+// Draw list of tracked peaks, selected one highlighted
+// Also updates menu length to number of peaks
+void Menu::drawPeaksMenu() {
+  // Copy kept so SELECT opens the peak that was drawn
+  peakList = receiver->getPeaks();
+  menus[PEAKS].menuItemsLength = std::max(peakList.length, 1);
+  menus[PEAKS].menuIndex = std::min(menus[PEAKS].menuIndex, menus[PEAKS].menuItemsLength - 1);
+
+  // Nothing to list until first complete sweep
+  if (peakList.generation == 0) {
+    const char *text = "Scanning...";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+    return;
+  }
+
+  if (peakList.length == 0) {
+    const char *text = "No signals";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+    return;
+  }
+
+  // Get min and max calibrated rssi
+  int minRssi = settings->lowCalibratedRssi.get();
+  int maxRssi = settings->highCalibratedRssi.get();
+
+  // Scroll so selection is always on screen
+  int selected = menus[PEAKS].menuIndex;
+  int first = std::max(0, selected - (VISIBLE_PEAKS - 1));
+  int last = std::min(peakList.length, first + VISIBLE_PEAKS);
+
+  u8g2.setFont(u8g2_font_5x7_tf);
+  for (int i = first; i < last; i++) {
+    const Peak &peak = peakList.peaks[i];
+    int y = 16 + (i - first) * 8;
+
+    // Id, centre frequency, bandwidth and strength
+    char row[26];
+    int percentage = map(std::clamp(peak.rssi, minRssi, maxRssi), minRssi, maxRssi, 0, 100);
+    snprintf(row, sizeof(row), "#%-3d %dMHz %2dMHz %3d%%", (int)(peak.id % 1000), peak.frequency, (peak.bandwidthKhz + 500) / 1000, percentage);
+
+    // Highlight selection
+    if (i == selected) {
+      u8g2.drawBox(0, y, DISPLAY_WIDTH, 8);
       u8g2.setDrawColor(0);
-      u8g2.drawBox(i * barWidth + padding, BAR_Y_MAX - barHeight, barWidth, barHeight);
+      u8g2.drawStr(2, y + 7, row);
       u8g2.setDrawColor(1);
     } else {
-      u8g2.drawBox(i * barWidth + padding, BAR_Y_MAX - barHeight, barWidth, barHeight);
+      u8g2.drawStr(2, y + 7, row);
+    }
+  }
+}
+
+// Draw recent complete sweeps as rows scrolling down from newest at top
+// Strength is shown by density of lit pixels, as display is monochrome
+void Menu::drawWaterfallMenu() {
+  ScanPlan plan;
+  int numColumns;
+  int numRows = receiver->getWaterfall(waterfallRows, WATERFALL_ROWS, DISPLAY_WIDTH, numColumns, plan);
+
+  // Nothing to draw until first complete sweep
+  if (numRows == 0) {
+    const char *text = "Scanning...";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+    return;
+  }
+
+  // Calculate width of each column by expanding until best fit
+  int barWidth = 1;
+  while ((barWidth + 1) * numColumns <= DISPLAY_WIDTH) {
+    barWidth++;
+  }
+  int padding = (DISPLAY_WIDTH - (barWidth * numColumns)) / 2;
+
+  // Get min and max calibrated rssi
+  int minRssi = settings->lowCalibratedRssi.get();
+  int maxRssi = settings->highCalibratedRssi.get();
+
+  // Ordered dither thresholds, so each of 5 strength levels lights a different share of pixels
+  const int dither[2][2] = { { 0, 2 }, { 3, 1 } };
+
+  for (int row = 0; row < numRows; row++) {
+    int y = WATERFALL_Y_MIN + row;
+    for (int column = 0; column < numColumns; column++) {
+      // Undo quantisation, then clamp between calibrated values
+      int rssi = std::clamp((waterfallRows[row * numColumns + column] << HISTORY_SHIFT) + (1 << HISTORY_SHIFT) / 2, minRssi, maxRssi);
+      int level = map(rssi, minRssi, maxRssi, 0, 4);
+
+      for (int x = column * barWidth + padding; x < (column + 1) * barWidth + padding; x++) {
+        if (level > dither[y % 2][x % 2]) u8g2.drawPixel(x, y);
+      }
     }
   }
+
+  // Draw bottom numbers
+  char frequencyLabel[5];
+  u8g2.setFont(u8g2_font_5x7_tf);
+  snprintf(frequencyLabel, sizeof(frequencyLabel), "%d", plan.minFrequency);
+  u8g2.drawStr(0, DISPLAY_HEIGHT, frequencyLabel);
+  snprintf(frequencyLabel, sizeof(frequencyLabel), "%d", plan.frequency(plan.length / 2));
+  u8g2.drawStr(55, DISPLAY_HEIGHT, frequencyLabel);
+  snprintf(frequencyLabel, sizeof(frequencyLabel), "%d", plan.maxFrequency);
+  u8g2.drawStr(109, DISPLAY_HEIGHT, frequencyLabel);
 }
 
 // Draw static content on about menu
@@ -444,6 +752,36 @@ void Menu::drawSerialMenu() {
   u8g2.drawStr(textCentreX(info, 7), 44, info);
 }
 
+// Draw auto-tune results or progress
+void Menu::drawAutoTuneMenu() {
+  // Scanning task clears once finished
+  if (receiver->autoTuning.get()) {
+    const char *text = "Tuning...";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+    return;
+  }
+
+  int settleTime = settings->tunedSettleTime.get();
+  int samples = settings->tunedSamples.get();
+
+  if (settleTime == DEFAULT_TUNED) {
+    const char *text = "Not tuned";
+    u8g2.drawStr(textCentreX(text, 7), 36, text);
+  } else {
+    char settleString[17];
+    snprintf(settleString, sizeof(settleString), "Settle %dus", settleTime);
+    u8g2.drawStr(textCentreX(settleString, 7), 28, settleString);
+
+    char samplesString[17];
+    snprintf(samplesString, sizeof(samplesString), "Samples %d", samples);
+    u8g2.drawStr(textCentreX(samplesString, 7), 44, samplesString);
+  }
+
+  u8g2.setFont(u8g2_font_5x7_tf);
+  const char *text = "Press SEL to tune";
+  u8g2.drawStr(textCentreX(text, 5), 60, text);
+}
+
 // Update icons for selected settings options
 void Menu::updateSettingsOptionIcons(menuStruct *menu, int selectedIndex) {
   for (int i = 0; i < menu->menuItemsLength; i++) {
@@ -459,18 +797,37 @@ void Menu::updateSettingsOptionIcons(menuStruct *menu, int selectedIndex) {
 void Menu::initMenus() {
   // Main menu
   mainMenuItems[0] = { "Scan", bitmap_Scan };
-  mainMenuItems[1] = { "Settings", bitmap_Settings };
-  mainMenuItems[2] = { "About", bitmap_About };
+  mainMenuItems[1] = { "Finder", bitmap_Wifi };
+  mainMenuItems[2] = { "Peaks", bitmap_Scan };
+  mainMenuItems[3] = { "Waterfall", bitmap_Interval };
+  mainMenuItems[4] = { "Settings", bitmap_Settings };
+  mainMenuItems[5] = { "About", bitmap_About };
 
   // Settings menu
   settingsMenuItems[0] = { "Scan interval", bitmap_Interval };
-  settingsMenuItems[1] = { "Buzzer", bitmap_Buzzer };
-  settingsMenuItems[2] = { "Bat. alarm", bitmap_Alarm };
+  settingsMenuItems[1] = { "Sweep order", bitmap_Scan };
+  settingsMenuItems[2] = { "Trace", bitmap_Scan };
+  settingsMenuItems[3] = { "Buzzer", bitmap_Buzzer };
+  settingsMenuItems[4] = { "Bat. alarm", bitmap_Alarm };
 
   // Scan Interval menu
   scanIntervalMenuItems[0] = { "2.5MHz", bitmap_Blank };
   scanIntervalMenuItems[1] = { "5MHz", bitmap_Blank };
   scanIntervalMenuItems[2] = { "10MHz", bitmap_Blank };
+  scanIntervalMenuItems[3] = { "Channels", bitmap_Blank };
+  scanIntervalMenuItems[4] = { "Custom", bitmap_Blank };
+
+  // Sweep Order menu
+  sweepOrderMenuItems[0] = { "Linear", bitmap_Blank };
+  sweepOrderMenuItems[1] = { "Bit-reversed", bitmap_Blank };
+  sweepOrderMenuItems[2] = { "Interleaved", bitmap_Blank };
+  sweepOrderMenuItems[3] = { "Priority", bitmap_Blank };
+
+  // Trace menu
+  traceMenuItems[0] = { "Live", bitmap_Blank };
+  traceMenuItems[1] = { "Max hold", bitmap_Blank };
+  traceMenuItems[2] = { "Min hold", bitmap_Blank };
+  traceMenuItems[3] = { "Average", bitmap_Blank };
 
   // Buzzer menu
   buzzerMenuItems[0] = { "On", bitmap_Blank };
@@ -485,6 +842,7 @@ void Menu::initMenus() {
   advancedMenuItems[0] = { "Calibration", bitmap_Calibration };
   advancedMenuItems[1] = { "Wi-Fi", bitmap_Wifi };
   advancedMenuItems[2] = { "USB Serial", bitmap_Serial };
+  advancedMenuItems[3] = { "Auto-tune", bitmap_Calibration };
 
   // Calibration menu
   calibrationMenuItems[0] = { "Calib. high", bitmap_Wifi };
@@ -493,23 +851,29 @@ void Menu::initMenus() {
   // Hacky method of changing settings menu length
   // Stops battery alarm menu option being drawn
 #ifdef BATTERY_MONITORING
-  int settingsLength = 3;
+  int settingsLength = 5;
 #else
-  int settingsLength = 2;
+  int settingsLength = 4;
 #endif
 
   // Menus
-  menus[MAIN] = { "Hertz Hunter", mainMenuItems, 3, 0 };
+  menus[MAIN] = { "Hertz Hunter", mainMenuItems, 6, 0 };
   menus[SCAN] = { "Scan", nullptr, MAX_FREQUENCIES_SCANNED, 0 };
   menus[SETTINGS] = { "Settings", settingsMenuItems, settingsLength, 0 };
   menus[ABOUT] = { "About", nullptr, 1, 0 };
-  menus[ADVANCED] = { "Advanced", advancedMenuItems, 3, 0 };
-  menus[SCAN_INTERVAL] = { "Scan interval", scanIntervalMenuItems, 3, 0 };
+  menus[FINDER] = { "Finder", nullptr, MAX_FREQUENCIES_SCANNED, 0 };
+  menus[PEAKS] = { "Peaks", nullptr, 1, 0 };
+  menus[WATERFALL] = { "Waterfall", nullptr, 1, 0 };
+  menus[ADVANCED] = { "Advanced", advancedMenuItems, 4, 0 };
+  menus[SCAN_INTERVAL] = { "Scan interval", scanIntervalMenuItems, 5, 0 };
+  menus[SWEEP_ORDER] = { "Sweep order", sweepOrderMenuItems, 4, 0 };
+  menus[TRACE] = { "Trace", traceMenuItems, 4, 0 };
   menus[BUZZER] = { "Buzzer", buzzerMenuItems, 2, 0 };
   menus[BATTERY_ALARM] = { "Bat. alarm", batteryAlarmMenuItems, 3, 0 };
   menus[CALIBRATION] = { "Calibration", calibrationMenuItems, 2, 0 };
   menus[WIFI] = { "Wi-Fi", nullptr, 1, 0 };
   menus[USB_SERIAL] = { "USB Serial", nullptr, 1, 0 };
+  menus[AUTO_TUNE] = { "Auto-tune", nullptr, 1, 0 };
 }
 
 // Calculate x position of text to centre it on screen
@@ -24,6 +24,19 @@
 #define BAR_Y_MIN 14
 #define BAR_Y_MAX 57
 
+// Readings combined into each column of finder trace, so whole trace fits across display
+#define FINDER_TRACE_DECIMATION (FINDER_TRACE_LENGTH / DISPLAY_WIDTH)
+
+// Number of items that fit below title of selection menus
+#define VISIBLE_MENU_ITEMS 3
+
+// Number of peaks that fit below title of peaks menu in small font
+#define VISIBLE_PEAKS 6
+
+// Waterfall fills space between title and frequency labels, one sweep per row
+#define WATERFALL_Y_MIN 16
+#define WATERFALL_ROWS (BAR_Y_MAX - WATERFALL_Y_MIN)
+
 // Use rotary encoder instead of buttons for navigation
 // #define ROTARY_ENCODER_INPUT
 
@@ -34,13 +47,19 @@ enum MenuIndex {
   SCAN,
   SETTINGS,
   ABOUT,
+  FINDER,
+  PEAKS,
+  WATERFALL,
   ADVANCED,
   SCAN_INTERVAL,
+  SWEEP_ORDER,
+  TRACE,
   BUZZER,
   BATTERY_ALARM,
   CALIBRATION,
   WIFI,
   USB_SERIAL,
+  AUTO_TUNE,
   MENU_COUNT  // For array bounds checking
 };
 
@@ -74,19 +93,28 @@ private:
 
   void drawSelectionMenu();
   void drawScanMenu();
+  void drawFinderMenu();
+  void drawPeaksMenu();
+  void drawWaterfallMenu();
   void drawAboutMenu();
   void drawWifiMenu();
   void drawSerialMenu();
+  void drawAutoTuneMenu();
+  void toggleBand();
+  void setFocus(int frequency);
+  void setFinder(int frequency);
   void updateSettingsOptionIcons(menuStruct *menu, int selectedIndex);
   void initMenus();
   int textCentreX(const char *text, int fontCharWidth);
 
-  menuItemStruct mainMenuItems[3];
-  menuItemStruct settingsMenuItems[3];
-  menuItemStruct scanIntervalMenuItems[3];
+  menuItemStruct mainMenuItems[6];
+  menuItemStruct settingsMenuItems[5];
+  menuItemStruct scanIntervalMenuItems[5];
+  menuItemStruct sweepOrderMenuItems[4];
+  menuItemStruct traceMenuItems[4];
   menuItemStruct buzzerMenuItems[2];
   menuItemStruct batteryAlarmMenuItems[3];
-  menuItemStruct advancedMenuItems[3];
+  menuItemStruct advancedMenuItems[4];
   menuItemStruct calibrationMenuItems[2];
   menuStruct menus[MENU_COUNT];
 
@@ -104,6 +132,22 @@ private:
   unsigned long selectButtonPressTime;
   bool selectButtonHeld;
 
+  // Used to toggle band once per press of PREV and NEXT together
+  bool bandButtonsHeld;
+
+  // Cursor position in full sweep to return to when leaving focus
+  int focusReturnIndex;
+
+  // Finder readings copied for drawing trace, too big for loop stack
+  uint16_t finderTrace[FINDER_TRACE_LENGTH];
+  bool finderMuted;
+
+  // Peaks copied for drawing list, too big for loop stack
+  PeakList peakList;
+
+  // Recent sweeps copied for drawing waterfall, newest first
+  uint8_t waterfallRows[WATERFALL_ROWS * DISPLAY_WIDTH];
+
   Settings *settings;
   Buzzer *buzzer;
   RX5808 *receiver;
@@ -0,0 +1,87 @@
+#include "packed.h"
+
+// Store little-endian, independent of host byte order
+static void putU16(uint8_t *out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+}
+
+static void putU32(uint8_t *out, uint32_t value) {
+  putU16(out, value & 0xFFFF);
+  putU16(out + 2, value >> 16);
+}
+
+// Bytes written by writePackedSweep()
+size_t packedSweepSize(const Sweep *sweep, int bits) {
+  size_t size = PACKED_HEADER_SIZE + sweep->plan.length * (bits / 8);
+  if (sweep->plan.mode == CHANNELS) size += sweep->plan.length * 2;
+  return size;
+}
+
+// Write sweep straight from its buffer in small chunks, so nothing the size of the sweep is allocated
+// Header layout in bytes:
+//   0  version        uint8
+//   1  flags          uint8
+//   2  bits           uint8, 8 or 16 bits per value
+//   3  trace          uint8, matches TraceMode
+//   4  generation     uint32
+//   8  timestamp      uint32, ms
+//   12 min frequency  uint16, MHz
+//   14 max frequency  uint16, MHz
+//   16 interval       uint32, kHz
+//   20 count          uint16, number of values
+//   22 settle time    uint16, us
+void writePackedSweep(Print &out, const Sweep *sweep, TraceMode trace, int bits, int settleTime) {
+  const ScanPlan &plan = sweep->plan;
+
+  uint8_t flags = 0;
+  if (plan.lowband) flags |= PACKED_LOWBAND;
+  if (plan.mode == FOCUS) flags |= PACKED_FOCUS;
+  if (sweep->complete) flags |= PACKED_COMPLETE;
+  if (plan.mode == CHANNELS) flags |= PACKED_CHANNELS;
+
+  uint8_t chunk[PACKED_CHUNK_SIZE];
+  chunk[0] = PACKED_VERSION;
+  chunk[1] = flags;
+  chunk[2] = bits;
+  chunk[3] = trace;
+  putU32(&chunk[4], sweep->generation);
+  putU32(&chunk[8], sweep->timestamp);
+  putU16(&chunk[12], plan.minFrequency);
+  putU16(&chunk[14], plan.maxFrequency);
+  putU32(&chunk[16], plan.intervalKhz);
+  putU16(&chunk[20], plan.length);
+  putU16(&chunk[22], std::min(settleTime, 0xFFFF));
+  out.write(chunk, PACKED_HEADER_SIZE);
+
+  // Chunk size is even, so 16 bit values never straddle chunks
+  size_t used = 0;
+  for (int i = 0; i < plan.length; i++) {
+    uint16_t value = sweep->trace(trace, i);
+    if (bits == 8) {
+      chunk[used++] = value >> PACKED_8_BIT_SHIFT;
+    } else {
+      putU16(&chunk[used], value);
+      used += 2;
+    }
+    if (used == PACKED_CHUNK_SIZE) {
+      out.write(chunk, used);
+      used = 0;
+    }
+  }
+
+  // Channel table isn't evenly spaced, so give frequency of each value
+  if (plan.mode == CHANNELS) {
+    for (int i = 0; i < plan.length; i++) {
+      // 8 bit values can leave an odd number of bytes in chunk
+      if (used + 2 > PACKED_CHUNK_SIZE) {
+        out.write(chunk, used);
+        used = 0;
+      }
+      putU16(&chunk[used], plan.frequency(i));
+      used += 2;
+    }
+  }
+
+  if (used > 0) out.write(chunk, used);
+}
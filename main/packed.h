@@ -0,0 +1,46 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <Arduino.h>
+#include "RX5808.h"
+
+// Binary sweep format, much smaller and cheaper to build than json
+// Little-endian header, then one 8 or 16 bit value per frequency
+// Channel table sweeps are followed by the 16 bit frequency of each value in MHz
+#define PACKED_VERSION 1
+#define PACKED_HEADER_SIZE 24
+#define PACKED_8_BIT_SHIFT 4  // 12 bit adc readings shifted down to fit in 8 bits
+#define PACKED_CHUNK_SIZE 64  // Bytes written to output at once
+#define PACKED_MAX_SIZE (PACKED_HEADER_SIZE + MAX_FREQUENCIES_SCANNED * 4)  // Upper bound for any sweep
+
+// Header flags
+#define PACKED_LOWBAND 0x01
+#define PACKED_FOCUS 0x02
+#define PACKED_COMPLETE 0x04
+#define PACKED_CHANNELS 0x08
+#define PACKED_DELTA 0x10  // Changes since previous frame, see delta.h
+
+// Print into fixed size buffer, for transports that need the whole sweep before sending
+// Writes past capacity are dropped
+class PackedBuffer : public Print {
+public:
+  PackedBuffer(uint8_t *b, size_t c) : buffer(b), capacity(c), used(0) {}
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t len) override {
+    len = std::min(len, capacity - used);
+    memcpy(buffer + used, data, len);
+    used += len;
+    return len;
+  }
+  size_t length() const { return used; }
+
+private:
+  uint8_t *buffer;
+  size_t capacity;
+  size_t used;
+};
+
+size_t packedSweepSize(const Sweep *sweep, int bits);
+void writePackedSweep(Print &out, const Sweep *sweep, TraceMode trace, int bits, int settleTime);
+
+#endif
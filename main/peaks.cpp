@@ -0,0 +1,233 @@
+#include "peaks.h"
+
+PeakDetector::PeakDetector()
+  : foundLength(0), noiseSpread(0), nextId(1) {
+  list.length = 0;
+  list.noiseFloor = 0;
+  list.generation = 0;
+  plan = {};
+
+  peaksMutex = xSemaphoreCreateMutex();
+}
+
+// Find peaks in complete sweep and match them to tracked peaks
+// Called by scanning task after publishing, so values don't change while running
+void PeakDetector::update(const ScanPlan &sweepPlan, const VariableBufferRestricted<uint16_t> &values, uint32_t generation, unsigned long timestamp) {
+  setPlan(sweepPlan);
+
+  int length = sortBins(sweepPlan, values);
+  if (length == 0) return;
+
+  estimateNoise(length);
+  findPeaks(length, sweepPlan);
+
+  xSemaphoreTake(peaksMutex, portMAX_DELAY);
+  trackPeaks(timestamp);
+  list.generation = generation;
+  xSemaphoreGive(peaksMutex);
+}
+
+// Forget tracked peaks when frequencies scanned change
+// Called by scanning task as soon as plan is rebuilt, so old peaks aren't shown against new band
+void PeakDetector::setPlan(const ScanPlan &sweepPlan) {
+  xSemaphoreTake(peaksMutex, portMAX_DELAY);
+  if (!plan.sameFrequencies(sweepPlan)) {
+    plan = sweepPlan;
+    list.length = 0;
+    list.noiseFloor = 0;
+  }
+  xSemaphoreGive(peaksMutex);
+}
+
+// Copy of currently tracked peaks
+// Peaks are aged here too, as complete sweeps stop while paused or in finder mode
+PeakList PeakDetector::getPeaks() {
+  unsigned long now = millis();
+
+  xSemaphoreTake(peaksMutex, portMAX_DELAY);
+  PeakList copy = list;
+  xSemaphoreGive(peaksMutex);
+
+  int kept = 0;
+  for (int i = 0; i < copy.length; i++) {
+    if (now - copy.peaks[i].lastSeen <= PEAK_TIMEOUT) copy.peaks[kept++] = copy.peaks[i];
+  }
+  copy.length = kept;
+  return copy;
+}
+
+// Copy sweep into bins sorted by frequency, keeping strongest reading of duplicate frequencies
+// Only channel table needs sorting, uniform plans are already in order
+// Returns number of bins
+int PeakDetector::sortBins(const ScanPlan &plan, const VariableBufferRestricted<uint16_t> &values) {
+  int length = 0;
+  for (int i = 0; i < plan.length; i++) {
+    int frequency = plan.frequency(i);
+    int rssi = values.get(i);
+
+    // Insertion sort, linear for already sorted plans
+    int j = length;
+    while (j > 0 && binFrequency[j - 1] > frequency) j--;
+
+    if (j > 0 && binFrequency[j - 1] == frequency) {
+      binRssi[j - 1] = std::max(binRssi[j - 1], rssi);
+      continue;
+    }
+
+    for (int k = length; k > j; k--) {
+      binFrequency[k] = binFrequency[k - 1];
+      binRssi[k] = binRssi[k - 1];
+    }
+    binFrequency[j] = frequency;
+    binRssi[j] = rssi;
+    length++;
+  }
+  return length;
+}
+
+// Noise floor is median reading, as most of band is usually empty
+// Spread is median distance from floor, so isn't thrown off by transmitters
+void PeakDetector::estimateNoise(int length) {
+  for (int i = 0; i < length; i++) {
+    sortedRssi[i] = binRssi[i];
+  }
+  std::nth_element(sortedRssi, sortedRssi + length / 2, sortedRssi + length);
+  int noiseFloor = sortedRssi[length / 2];
+
+  for (int i = 0; i < length; i++) {
+    sortedRssi[i] = abs(binRssi[i] - noiseFloor);
+  }
+  std::nth_element(sortedRssi, sortedRssi + length / 2, sortedRssi + length);
+  noiseSpread = sortedRssi[length / 2];
+
+  xSemaphoreTake(peaksMutex, portMAX_DELAY);
+  list.noiseFloor = noiseFloor;
+  xSemaphoreGive(peaksMutex);
+}
+
+// Find local maxima with enough prominence and width
+void PeakDetector::findPeaks(int length, const ScanPlan &plan) {
+  foundLength = 0;
+  int minProminence = std::max(PEAK_MIN_PROMINENCE, PEAK_NOISE_MULTIPLIER * noiseSpread);
+
+  // Width only meaningful when bins are closer than narrowest allowed peak
+  bool checkWidth = plan.mode != CHANNELS && plan.intervalKhz < PEAK_MIN_WIDTH_KHZ;
+
+  for (int i = 0; i < length; i++) {
+    int rssi = binRssi[i];
+
+    // Leftmost bin of a plateau counts as the maximum
+    if (i > 0 && binRssi[i - 1] >= rssi) continue;
+    if (i < length - 1 && binRssi[i + 1] > rssi) continue;
+
+    // Lowest point on each side before reaching higher reading or edge of sweep
+    int left = i;
+    int leftBase = rssi;
+    while (left > 0 && binRssi[left - 1] <= rssi) {
+      left--;
+      leftBase = std::min(leftBase, binRssi[left]);
+    }
+    int right = i;
+    int rightBase = rssi;
+    while (right < length - 1 && binRssi[right + 1] <= rssi) {
+      right++;
+      rightBase = std::min(rightBase, binRssi[right]);
+    }
+
+    int prominence = rssi - std::max(leftBase, rightBase);
+    if (prominence < minProminence) continue;
+
+    // Width where readings drop below half prominence, interpolated between bins
+    int level = rssi - prominence / 2;
+    int low = i;
+    while (low > 0 && binRssi[low - 1] > level) low--;
+    int high = i;
+    while (high < length - 1 && binRssi[high + 1] > level) high++;
+    int lowKhz = low > 0 ? crossing(low, low - 1, level) : binFrequency[low] * 1000;
+    int highKhz = high < length - 1 ? crossing(high, high + 1, level) : binFrequency[high] * 1000;
+
+    if (checkWidth && highKhz - lowKhz < PEAK_MIN_WIDTH_KHZ) continue;
+
+    Peak peak = {};
+    peak.frequency = ((lowKhz + highKhz) / 2 + 500) / 1000;
+    peak.bandwidthKhz = highKhz - lowKhz;
+    peak.rssi = rssi;
+    peak.prominence = prominence;
+    addFound(peak);
+  }
+}
+
+// Keep peak if there's room or it's more prominent than weakest found so far
+void PeakDetector::addFound(const Peak &peak) {
+  if (foundLength < MAX_PEAKS) {
+    found[foundLength++] = peak;
+    return;
+  }
+
+  int weakest = 0;
+  for (int i = 1; i < foundLength; i++) {
+    if (found[i].prominence < found[weakest].prominence) weakest = i;
+  }
+  if (peak.prominence > found[weakest].prominence) found[weakest] = peak;
+}
+
+// Frequency in kHz where readings cross level between bin above level and neighbouring bin at or below it
+int PeakDetector::crossing(int from, int to, int level) {
+  int fromKhz = binFrequency[from] * 1000;
+  int toKhz = binFrequency[to] * 1000;
+  return fromKhz + (toKhz - fromKhz) * (binRssi[from] - level) / (binRssi[from] - binRssi[to]);
+}
+
+// Match found peaks to nearest tracked peak, most prominent first, starting new tracks for the rest
+// Take peaksMutex before calling
+void PeakDetector::trackPeaks(unsigned long timestamp) {
+  std::sort(found, found + foundLength, [](const Peak &a, const Peak &b) {
+    return a.prominence > b.prominence;
+  });
+
+  bool matched[MAX_PEAKS] = {};
+  for (int i = 0; i < foundLength; i++) {
+    Peak &peak = found[i];
+
+    int nearest = -1;
+    for (int j = 0; j < list.length; j++) {
+      int distance = abs(list.peaks[j].frequency - peak.frequency);
+      if (!matched[j] && distance <= PEAK_MATCH_DISTANCE
+          && (nearest < 0 || distance < abs(list.peaks[nearest].frequency - peak.frequency))) {
+        nearest = j;
+      }
+    }
+
+    // Replace longest unseen peak if full
+    if (nearest < 0) {
+      if (list.length < MAX_PEAKS) {
+        nearest = list.length++;
+      } else {
+        for (int j = 0; j < list.length; j++) {
+          if (!matched[j] && (nearest < 0 || list.peaks[j].lastSeen < list.peaks[nearest].lastSeen)) nearest = j;
+        }
+      }
+      list.peaks[nearest].id = nextId++;
+      list.peaks[nearest].firstSeen = timestamp;
+    }
+
+    Peak &tracked = list.peaks[nearest];
+    tracked.frequency = peak.frequency;
+    tracked.bandwidthKhz = peak.bandwidthKhz;
+    tracked.rssi = peak.rssi;
+    tracked.prominence = peak.prominence;
+    tracked.lastSeen = timestamp;
+    matched[nearest] = true;
+  }
+
+  // Drop peaks that have gone
+  int kept = 0;
+  for (int i = 0; i < list.length; i++) {
+    if (timestamp - list.peaks[i].lastSeen <= PEAK_TIMEOUT) list.peaks[kept++] = list.peaks[i];
+  }
+  list.length = kept;
+
+  std::sort(list.peaks, list.peaks + list.length, [](const Peak &a, const Peak &b) {
+    return a.frequency < b.frequency;
+  });
+}
@@ -0,0 +1,66 @@
+#ifndef PEAKS_H
+#define PEAKS_H
+
+#include <Arduino.h>
+#include "scanplan.h"
+#include "variable.h"
+
+#define MAX_PEAKS 16  // Transmitters tracked at once, weakest new peaks dropped past this
+
+#define PEAK_MIN_PROMINENCE 150    // Least rise above surrounding bases to count as peak, in adc units
+#define PEAK_NOISE_MULTIPLIER 4    // Prominence must also be this many times noise spread above noise floor
+#define PEAK_MIN_WIDTH_KHZ 3000    // Narrower peaks are noise spikes, only checked when scan interval is finer
+#define PEAK_MATCH_DISTANCE 8      // Peaks within this many MHz of tracked peak are the same transmitter
+#define PEAK_TIMEOUT 5000          // Tracked peaks not seen for this long in ms are dropped
+
+// Transmitter found in sweeps and tracked between them
+struct Peak {
+  uint32_t id;                // Stays the same while peak is tracked, never reused
+  int frequency;              // Centre in MHz, midway between half prominence points
+  int bandwidthKhz;           // Width at half prominence
+  int rssi;                   // Strongest reading
+  int prominence;             // Rise above higher of surrounding bases
+  unsigned long firstSeen;    // ms
+  unsigned long lastSeen;     // ms
+};
+
+// Copy of tracked peaks handed to readers
+struct PeakList {
+  Peak peaks[MAX_PEAKS];  // Sorted by frequency
+  int length;
+  int noiseFloor;       // Median reading of last sweep
+  uint32_t generation;  // Sweep peaks last updated from, 0 before first
+};
+
+// Finds peaks in each complete sweep and tracks them across sweeps
+// Updated by scanning task, read by anything through getPeaks()
+class PeakDetector {
+public:
+  PeakDetector();
+  void update(const ScanPlan &plan, const VariableBufferRestricted<uint16_t> &values, uint32_t generation, unsigned long timestamp);
+  void setPlan(const ScanPlan &sweepPlan);
+  PeakList getPeaks();
+
+private:
+  int sortBins(const ScanPlan &plan, const VariableBufferRestricted<uint16_t> &values);
+  void estimateNoise(int length);
+  void findPeaks(int length, const ScanPlan &plan);
+  void addFound(const Peak &peak);
+  void trackPeaks(unsigned long timestamp);
+  int crossing(int from, int to, int level);
+
+  // Only used by scanning task
+  uint16_t binFrequency[MAX_FREQUENCIES_SCANNED];  // MHz, ascending with duplicates merged
+  int binRssi[MAX_FREQUENCIES_SCANNED];
+  int sortedRssi[MAX_FREQUENCIES_SCANNED];  // Scratch space for median
+  Peak found[MAX_PEAKS];  // Peaks in latest sweep, strongest prominence kept
+  int foundLength;
+  int noiseSpread;        // Median distance of readings from noise floor
+  uint32_t nextId;
+
+  PeakList list;
+  ScanPlan plan;  // Frequencies tracked peaks were found in
+  SemaphoreHandle_t peaksMutex;
+};
+
+#endif
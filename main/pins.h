@@ -11,6 +11,13 @@
 
 #define RSSI_PIN 3
 
+// Number of RX5808 modules, up to 4
+// Extra modules share data and clock pins, each needs its own le pin and adc capable rssi pin
+#define RX5808_MODULES 1
+#define SPI_LE_PIN_2 5
+#define RSSI_PIN_2 1
+// Define SPI_LE_PIN_3, RSSI_PIN_3, SPI_LE_PIN_4 and RSSI_PIN_4 for a board with more free pins
+
 #define BUZZER_PIN 2
 
 #define BATTERY_PIN 0
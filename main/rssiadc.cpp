@@ -0,0 +1,108 @@
+#include "rssiadc.h"
+
+RssiAdc::RssiAdc(uint8_t p, RssiReduction r)
+  : pin(p), reduction(r), handle(NULL), channel(ADC_CHANNEL_0) {}
+
+// Read rssi by collecting a window of dma samples and reducing them
+// Returns -1 if the adc couldn't be read
+int RssiAdc::read(int numSamples) {
+  // Driver is set up on first use as it can't be done before setup() runs
+  if (handle == NULL && !begin()) return -1;
+
+  numSamples = std::clamp(numSamples, 1, RSSI_ADC_MAX_SAMPLES);
+
+  // Conversions only run while sampling so oneshot reads on other pins (e.g. battery) can still take the adc
+  if (adc_continuous_start(handle) != ESP_OK) return -1;
+
+  // Reads are rejected while stopped, so stale conversions can only be flushed once running
+  drain();
+
+  // Collect samples, blocking until enough dma data is ready
+  int count = 0;
+  while (count < numSamples) {
+    uint32_t wanted = std::min((uint32_t)sizeof(frame), (uint32_t)(numSamples - count) * SOC_ADC_DIGI_RESULT_BYTES);
+    uint32_t length = 0;
+    if (adc_continuous_read(handle, frame, wanted, &length, RSSI_ADC_TIMEOUT) != ESP_OK) break;
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length && count < numSamples; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      adc_digi_output_data_t *result = (adc_digi_output_data_t *)&frame[i];
+      if (result->type2.channel == channel) samples[count++] = result->type2.data;
+    }
+  }
+
+  adc_continuous_stop(handle);
+
+  if (count == 0) return -1;
+
+  return reduce(count);
+}
+
+// Create continuous adc driver for rssi pin
+bool RssiAdc::begin() {
+  adc_unit_t unit;
+  if (adc_continuous_io_to_channel(pin, &unit, &channel) != ESP_OK) return false;
+
+  adc_continuous_handle_cfg_t handleConfig = {};
+  handleConfig.max_store_buf_size = RSSI_ADC_FRAME_SIZE * 4;
+  handleConfig.conv_frame_size = RSSI_ADC_FRAME_SIZE;
+  if (adc_continuous_new_handle(&handleConfig, &handle) != ESP_OK) {
+    handle = NULL;
+    return false;
+  }
+
+  // Match attenuation used by analogRead() so readings are comparable with calibration
+  adc_digi_pattern_config_t pattern = {};
+  pattern.atten = ADC_ATTEN_DB_12;
+  pattern.channel = channel;
+  pattern.unit = unit;
+  pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_continuous_config_t config = {};
+  config.pattern_num = 1;
+  config.adc_pattern = &pattern;
+  config.sample_freq_hz = RSSI_ADC_SAMPLE_FREQUENCY;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+  if (adc_continuous_config(handle, &config) != ESP_OK) {
+    adc_continuous_deinit(handle);
+    handle = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+// Discard stale conversions left over from previous window
+// Must be called while driver is started
+void RssiAdc::drain() {
+  uint32_t length = 0;
+  while (adc_continuous_read(handle, frame, sizeof(frame), &length, 0) == ESP_OK) {}
+}
+
+// Reduce collected samples to single reading
+int RssiAdc::reduce(int count) {
+  switch (reduction) {
+    case MEDIAN:
+      std::nth_element(samples, samples + count / 2, samples + count);
+      return samples[count / 2];
+    case TRIMMED_MEAN:
+      {
+        // Discard outliers at both ends before averaging
+        std::sort(samples, samples + count);
+        int trim = count * RSSI_ADC_TRIM_PERCENT / 100;
+        int total = 0;
+        for (int i = trim; i < count - trim; i++) {
+          total += samples[i];
+        }
+        return total / (count - 2 * trim);
+      }
+    default:
+      {
+        int total = 0;
+        for (int i = 0; i < count; i++) {
+          total += samples[i];
+        }
+        return total / count;
+      }
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef RSSIADC_H
+#define RSSIADC_H
+
+#include <Arduino.h>
+#include "esp_adc/adc_continuous.h"
+
+#define RSSI_ADC_MAX_SAMPLES 256
+#define RSSI_ADC_SAMPLE_FREQUENCY 40000  // Conversions per second
+#define RSSI_ADC_FRAME_SIZE 64           // Bytes per dma frame, multiple of SOC_ADC_DIGI_RESULT_BYTES, small so short windows are quick
+#define RSSI_ADC_TIMEOUT 20              // Max time to wait for a dma frame in ms
+#define RSSI_ADC_TRIM_PERCENT 20         // Percentage of samples discarded from each end for trimmed mean
+
+// Methods of reducing a window of samples to a single reading
+enum RssiReduction {
+  MEAN,
+  MEDIAN,
+  TRIMMED_MEAN
+};
+
+// Continuous-mode rssi sampling using the adc dma engine
+// Task blocks while the dma fills the sample buffer, leaving the cpu free
+class RssiAdc {
+public:
+  RssiAdc(uint8_t p, RssiReduction r);
+  int read(int numSamples);
+
+private:
+  bool begin();
+  void drain();
+  int reduce(int count);
+
+  uint8_t pin;
+  RssiReduction reduction;
+
+  adc_continuous_handle_t handle;
+  adc_channel_t channel;
+
+  uint16_t samples[RSSI_ADC_MAX_SAMPLES];
+  uint8_t frame[RSSI_ADC_FRAME_SIZE];
+};
+
+#endif
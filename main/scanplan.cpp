@@ -0,0 +1,194 @@
+#include "scanplan.h"
+
+// Register word for every MHz in tunable range
+// Built at compile time and stored in flash
+struct RegisterTable {
+  constexpr RegisterTable()
+    : words() {
+    for (int i = 0; i < LENGTH; i++) {
+      words[i] = calculateRegister(RX5808_MIN_FREQUENCY + i);
+    }
+  }
+
+  // Every entry matches formula and decodes back to local oscillator frequency (479MHz below, in 2MHz steps)
+  constexpr bool valid() const {
+    for (int i = 0; i < LENGTH; i++) {
+      int frequency = RX5808_MIN_FREQUENCY + i;
+      int n = words[i] >> 7;
+      int a = words[i] & 0x7F;
+      if (words[i] != calculateRegister(frequency) || a > 31 || 64 * n + 2 * a != ((frequency - 479) & ~1)) return false;
+    }
+    return true;
+  }
+
+  static constexpr int LENGTH = RX5808_MAX_FREQUENCY - RX5808_MIN_FREQUENCY + 1;
+  uint16_t words[LENGTH];
+};
+
+static constexpr RegisterTable registerTable;
+static_assert(registerTable.valid(), "RX5808 register table doesn't match frequency formula");
+static_assert(registerTable.words[5800 - RX5808_MIN_FREQUENCY] == 0x2984, "RX5808 register table has wrong value for F4");
+
+// Standard analog FPV channels (bands A, B, E, F, R and L), sorted by frequency
+// Channels sharing a frequency are merged into one entry
+struct Channel {
+  const char *name;
+  uint16_t frequency;
+};
+
+static constexpr Channel channelTable[] = {
+  { "L1", 5362 }, { "L2", 5399 }, { "L3", 5436 }, { "L4", 5473 },
+  { "L5", 5510 }, { "L6", 5547 }, { "L7", 5584 }, { "L8", 5621 },
+  { "E4", 5645 }, { "R1", 5658 }, { "E3", 5665 }, { "E2", 5685 },
+  { "R2", 5695 }, { "E1", 5705 }, { "A8", 5725 }, { "R3", 5732 },
+  { "B1", 5733 }, { "F1", 5740 }, { "A7", 5745 }, { "B2", 5752 },
+  { "F2", 5760 }, { "A6", 5765 }, { "R4", 5769 }, { "B3", 5771 },
+  { "F3", 5780 }, { "A5", 5785 }, { "B4", 5790 }, { "F4", 5800 },
+  { "A4", 5805 }, { "R5", 5806 }, { "B5", 5809 }, { "F5", 5820 },
+  { "A3", 5825 }, { "B6", 5828 }, { "F6", 5840 }, { "R6", 5843 },
+  { "A2", 5845 }, { "B7", 5847 }, { "F7", 5860 }, { "A1", 5865 },
+  { "B8", 5866 }, { "F8/R7", 5880 }, { "E5", 5885 }, { "E6", 5905 },
+  { "R8", 5917 }, { "E7", 5925 }, { "E8", 5945 }
+};
+
+static constexpr int CHANNEL_TABLE_LENGTH = sizeof(channelTable) / sizeof(channelTable[0]);
+
+// Strictly increasing so frequencies are unique and graph is in order
+constexpr bool channelTableSorted() {
+  for (int i = 1; i < CHANNEL_TABLE_LENGTH; i++) {
+    if (channelTable[i].frequency <= channelTable[i - 1].frequency) return false;
+  }
+  return true;
+}
+
+static_assert(channelTableSorted(), "Channel table must be sorted by frequency without duplicates");
+static_assert(CHANNEL_TABLE_LENGTH <= MAX_FREQUENCIES_SCANNED, "Channel table doesn't fit in scan plan");
+
+// Last frequency scanned from min towards max at interval, falls short of max when interval doesn't divide range
+static int lastFrequency(int minFrequency, int maxFrequency, int intervalKhz) {
+  return minFrequency + (maxFrequency - minFrequency) * 1000 / intervalKhz * intervalKhz / 1000;
+}
+
+// Calculate range of frequencies scanned for config
+void ScanPlan::build(const ScanConfig &config) {
+  mode = config.mode;
+  lowband = config.lowband;
+  sweepOrder = config.order;
+
+  if (mode == CHANNELS) {
+    // Centre frequencies of standard channels, covers both bands
+    intervalKhz = CHANNEL_TABLE_INTERVAL;
+    minFrequency = channelTable[0].frequency;
+    maxFrequency = channelTable[CHANNEL_TABLE_LENGTH - 1].frequency;
+    length = CHANNEL_TABLE_LENGTH;
+  } else {
+    // Evenly spaced frequencies across range, max is last one actually scanned
+    intervalKhz = config.intervalKhz;
+    minFrequency = config.minFrequency;
+    maxFrequency = lastFrequency(config.minFrequency, config.maxFrequency, intervalKhz);
+    length = (config.maxFrequency - minFrequency) * 1000 / intervalKhz + 1;  // +1 for final number inclusion
+  }
+}
+
+// Plan was built for given config
+bool ScanPlan::matches(const ScanConfig &config) const {
+  if (mode != config.mode || lowband != config.lowband || sweepOrder != config.order) return false;
+  if (mode == CHANNELS) return true;
+  return minFrequency == config.minFrequency && intervalKhz == config.intervalKhz
+         && maxFrequency == lastFrequency(config.minFrequency, config.maxFrequency, config.intervalKhz);
+}
+
+// Plans scan exactly the same frequencies
+bool ScanPlan::sameFrequencies(const ScanPlan &other) const {
+  return mode == other.mode && minFrequency == other.minFrequency && intervalKhz == other.intervalKhz && length == other.length;
+}
+
+// Frequency of value at index in MHz
+int ScanPlan::frequency(int index) const {
+  if (mode == CHANNELS) return channelTable[index].frequency;
+
+  // RX5808 only supports 1MHz increments so round to nearest
+  return minFrequency + (index * intervalKhz + 500) / 1000;
+}
+
+// RX5808 synthesizer register word for frequency at index
+uint16_t ScanPlan::registerWord(int index) const {
+  return frequencyToRegister(frequency(index));
+}
+
+// Channel name of frequency at index, nullptr if not scanning channel table
+const char *ScanPlan::channel(int index) const {
+  return mode == CHANNELS ? channelTable[index].name : nullptr;
+}
+
+// Whether partially complete sweep should be published after given number of steps
+// Non-linear orders have evenly spaced coverage each time steps doubles, so publish then
+// Priority order publishes often so revisited frequencies update quickly
+bool ScanPlan::publishAfter(int steps) const {
+  if (sweepOrder == LINEAR || steps >= length) return false;
+  if (sweepOrder == PRIORITY) return steps % PRIORITY_PUBLISH_INTERVAL == 0;
+  return steps >= 4 && (steps & (steps - 1)) == 0;
+}
+
+// Calculate index of frequency scanned at each step
+// Order must have space for length entries
+void ScanPlan::buildOrder(uint16_t *order) const {
+  int step = 0;
+
+  switch (sweepOrder) {
+    case BIT_REVERSED:
+      {
+        // Bits needed to index every frequency
+        int bits = 0;
+        while ((1 << bits) < length) bits++;
+
+        // Reverse bits of each counter value, skipping those past end
+        for (int counter = 0; counter < (1 << bits); counter++) {
+          int reversed = 0;
+          for (int b = 0; b < bits; b++) {
+            if (counter & (1 << b)) reversed |= 1 << (bits - 1 - b);
+          }
+          if (reversed < length) order[step++] = reversed;
+        }
+        break;
+      }
+    case INTERLEAVED:
+      {
+        // Largest power of two stride that fits in band
+        int stride = 1;
+        while (stride * 2 < length) stride *= 2;
+
+        // Visit every stride, then halve stride and visit ones in between
+        for (int i = 0; i < length; i += stride) {
+          order[step++] = i;
+        }
+        for (; stride > 1; stride /= 2) {
+          for (int i = stride / 2; i < length; i += stride) {
+            order[step++] = i;
+          }
+        }
+        break;
+      }
+    default:
+      for (int i = 0; i < length; i++) {
+        order[step++] = i;
+      }
+      break;
+  }
+}
+
+// Convert frequency number to required binary representation
+uint16_t frequencyToRegister(int frequency) {
+  // Look up precalculated value when in table
+  if (frequency >= RX5808_MIN_FREQUENCY && frequency <= RX5808_MAX_FREQUENCY) {
+    return registerTable.words[frequency - RX5808_MIN_FREQUENCY];
+  }
+
+  return calculateRegister(frequency);
+}
+
+// Lowest frequency of focus window around frequency
+// Window is shifted rather than narrowed near the ends of the tunable range
+int focusMinFrequency(int frequency) {
+  return std::clamp(frequency - FOCUS_HALF_WIDTH, RX5808_MIN_FREQUENCY, RX5808_MAX_FREQUENCY - 2 * FOCUS_HALF_WIDTH);
+}
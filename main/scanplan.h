@@ -0,0 +1,88 @@
+#ifndef SCANPLAN_H
+#define SCANPLAN_H
+
+#include <Arduino.h>
+
+#define HIGHBAND_MIN_FREQUENCY 5645
+#define LOWBAND_MIN_FREQUENCY 5345
+#define SCAN_FREQUENCY_RANGE 300
+
+// Tunable range of RX5808 covered by register lookup table
+#define RX5808_MIN_FREQUENCY 5300
+#define RX5808_MAX_FREQUENCY 6000
+
+// Every MHz across tunable range
+#define MAX_FREQUENCIES_SCANNED (RX5808_MAX_FREQUENCY - RX5808_MIN_FREQUENCY + 1)
+
+// Narrow window scanned around a frequency in focus mode
+#define FOCUS_HALF_WIDTH 20      // MHz either side of focused frequency
+#define FOCUS_INTERVAL_KHZ 1000  // Every MHz, the finest the RX5808 supports
+
+// Scan interval meaning scan standard FPV channel table instead of uniform grid
+#define CHANNEL_TABLE_INTERVAL 0
+
+// Background steps between publishing partial sweeps in priority order
+#define PRIORITY_PUBLISH_INTERVAL 4
+
+// Order frequencies are visited in during a sweep
+// Bit-reversed and interleaved give evenly spaced coverage of the band part way through a sweep
+// Priority scans linearly, revisiting frequencies with activity between each step
+enum SweepOrder {
+  LINEAR,
+  BIT_REVERSED,
+  INTERLEAVED,
+  PRIORITY
+};
+
+// What frequencies are scanned
+enum ScanMode {
+  BAND,      // Fixed width high or low band
+  CHANNELS,  // Standard FPV channel table
+  RANGE,     // Custom start, stop and step
+  FOCUS,     // Narrow window around a frequency
+  TRACK      // Single frequency sampled continuously for finder
+};
+
+// Configuration sent to scanning task with RX5808::reconfigure()
+struct ScanConfig {
+  ScanMode mode;
+  int minFrequency;  // MHz, ignored for channel table
+  int maxFrequency;  // MHz, ignored for channel table
+  int intervalKhz;   // Interval between frequencies in kHz, ignored for channel table
+  bool lowband;
+  SweepOrder order;
+  unsigned long maxSettleTime;  // Longest time to wait for rssi to settle after retuning in us
+  int samples;                  // Rssi samples averaged per frequency
+};
+
+// Frequencies scanned in a sweep
+// Small enough to copy into every sweep, frequencies are calculated with integer maths and register words looked up
+struct ScanPlan {
+  void build(const ScanConfig &config);
+  bool matches(const ScanConfig &config) const;
+  bool sameFrequencies(const ScanPlan &other) const;
+  bool publishAfter(int steps) const;
+  void buildOrder(uint16_t *order) const;
+  int frequency(int index) const;
+  uint16_t registerWord(int index) const;
+  const char *channel(int index) const;
+
+  ScanMode mode;
+  int length;        // Number of frequencies scanned
+  int minFrequency;  // MHz
+  int maxFrequency;  // MHz, last frequency scanned
+  int intervalKhz;   // Interval between frequencies in kHz, CHANNEL_TABLE_INTERVAL for channel table
+  bool lowband;
+  SweepOrder sweepOrder;
+};
+
+// Calculate RX5808 synthesizer register word for frequency
+// Used to generate lookup table at compile time
+constexpr uint16_t calculateRegister(int frequency) {
+  return (((frequency - 479) / 64) << 7) | (((frequency - 479) % 64) / 2);
+}
+
+uint16_t frequencyToRegister(int frequency);
+int focusMinFrequency(int frequency);
+
+#endif
@@ -2,10 +2,13 @@
 
 Settings::Settings()
   // Initialise to defaults
-  : scanIntervalIndex(DEFAULT_INDEX), scanInterval(DEFAULT_SCAN_INTERVAL),
+  : scanIntervalIndex(DEFAULT_INDEX), scanIntervalKhz(DEFAULT_SCAN_INTERVAL_KHZ),
+    sweepOrderIndex(DEFAULT_INDEX), traceIndex(DEFAULT_INDEX),
+    rangeStart(DEFAULT_RANGE_START), rangeStop(DEFAULT_RANGE_STOP), rangeStep(DEFAULT_RANGE_STEP),
     buzzerIndex(DEFAULT_INDEX), buzzer(DEFAULT_BUZZER),
     batteryAlarmIndex(DEFAULT_INDEX), batteryAlarm(DEFAULT_BATTERY_ALARM),
     lowCalibratedRssi(DEFAULT_LOW_CALIBRATED_RSSI), highCalibratedRssi(DEFAULT_HIGH_CALIBRATED_RSSI),
+    tunedSettleTime(DEFAULT_TUNED), tunedSamples(DEFAULT_TUNED), deltaThreshold(DEFAULT_DELTA_THRESHOLD), revision(0),
     initialReadDone(false) {
 
   // Create settings mutex
@@ -13,10 +16,42 @@ Settings::Settings()
 
   // When interval index changes, update actual interval
   scanIntervalIndex.onChange([this](int val) {
-    scanInterval.set(2.5 * pow(2, val));
+    if (val == CHANNEL_TABLE_INDEX) {
+      scanIntervalKhz.set(CHANNEL_TABLE_INTERVAL);
+    } else if (val == CUSTOM_RANGE_INDEX) {
+      scanIntervalKhz.set(rangeStep.get() * 1000);
+    } else {
+      scanIntervalKhz.set(DEFAULT_SCAN_INTERVAL_KHZ << val);
+    }
     if (initialReadDone) saveSettingsStorage("s_i_index", val);
   });
 
+  // Write sweep order to storage on change
+  sweepOrderIndex.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("s_o_index", val);
+  });
+
+  // Write trace to storage on change
+  traceIndex.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("t_index", val);
+  });
+
+  // Write custom range to storage on change
+  rangeStart.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("r_start", val);
+  });
+
+  // Write custom range to storage on change
+  rangeStop.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("r_stop", val);
+  });
+
+  // When custom step changes, update actual interval if custom range in use
+  rangeStep.onChange([this](int val) {
+    if (scanIntervalIndex.get() == CUSTOM_RANGE_INDEX) scanIntervalKhz.set(val * 1000);
+    if (initialReadDone) saveSettingsStorage("r_step", val);
+  });
+
   // When buzzer index changes, update buzzer state
   buzzerIndex.onChange([this](int val) {
     buzzer.set(val == 0 ? true : false);
@@ -38,10 +73,37 @@ Settings::Settings()
   highCalibratedRssi.onChange([this](int val) {
     if (initialReadDone) saveSettingsStorage("h_c_rssi", val);
   });
+
+  // Write auto-tune results to storage on change
+  tunedSettleTime.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("t_settle", val);
+  });
+
+  // Write auto-tune results to storage on change
+  tunedSamples.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("t_samples", val);
+  });
+
+  // Write module calibration offsets to storage on change
+  for (int i = 0; i < MAX_RX5808_MODULES; i++) {
+    rssiOffsets[i].onChange([this, i](int val) {
+      char key[8];
+      snprintf(key, sizeof(key), "r_off_%d", i);
+      if (initialReadDone) saveSettingsStorage(key, val);
+    });
+  }
+
+  // Write delta threshold to storage on change
+  deltaThreshold.onChange([this](int val) {
+    if (initialReadDone) saveSettingsStorage("d_thresh", val);
+  });
 }
 
 // Save given value to given key
+// Every setting is saved when changed, so revision is counted here
 void Settings::saveSettingsStorage(const char *key, int value) {
+  revision.set(revision.get() + 1);
+
   preferences.begin("settings", false);
   preferences.putInt(key, value);
   preferences.end();
@@ -51,11 +113,25 @@ void Settings::saveSettingsStorage(const char *key, int value) {
 void Settings::loadSettingsStorage() {
   preferences.begin("settings", true);
   xSemaphoreTake(settingsMutex, portMAX_DELAY);
+  // Load range before index so custom interval is calculated from stored step
+  rangeStart.set(preferences.getInt("r_start", DEFAULT_RANGE_START));
+  rangeStop.set(preferences.getInt("r_stop", DEFAULT_RANGE_STOP));
+  rangeStep.set(preferences.getInt("r_step", DEFAULT_RANGE_STEP));
   scanIntervalIndex.set(preferences.getInt("s_i_index", DEFAULT_INDEX));
+  sweepOrderIndex.set(preferences.getInt("s_o_index", DEFAULT_INDEX));
+  traceIndex.set(preferences.getInt("t_index", DEFAULT_INDEX));
   buzzerIndex.set(preferences.getInt("b_index", DEFAULT_INDEX));
   batteryAlarmIndex.set(preferences.getInt("b_a_index", DEFAULT_INDEX));
   lowCalibratedRssi.set(preferences.getInt("l_c_rssi", DEFAULT_LOW_CALIBRATED_RSSI));
   highCalibratedRssi.set(preferences.getInt("h_c_rssi", DEFAULT_HIGH_CALIBRATED_RSSI));
+  tunedSettleTime.set(preferences.getInt("t_settle", DEFAULT_TUNED));
+  tunedSamples.set(preferences.getInt("t_samples", DEFAULT_TUNED));
+  for (int i = 0; i < MAX_RX5808_MODULES; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "r_off_%d", i);
+    rssiOffsets[i].set(preferences.getInt(key, DEFAULT_RSSI_OFFSET));
+  }
+  deltaThreshold.set(preferences.getInt("d_thresh", DEFAULT_DELTA_THRESHOLD));
   xSemaphoreGive(settingsMutex);
   preferences.end();
 
@@ -4,14 +4,25 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include "esp_system.h"
+#include "scanplan.h"
 #include "variable.h"
 
 #define DEFAULT_INDEX 0
-#define DEFAULT_SCAN_INTERVAL 2.5
+#define DEFAULT_SCAN_INTERVAL_KHZ 2500
+#define CHANNEL_TABLE_INDEX 3  // Scan interval index for scanning standard channels
+#define CUSTOM_RANGE_INDEX 4   // Scan interval index for scanning custom range
+#define DEFAULT_RANGE_START RX5808_MIN_FREQUENCY
+#define DEFAULT_RANGE_STOP RX5808_MAX_FREQUENCY
+#define DEFAULT_RANGE_STEP 5
 #define DEFAULT_BUZZER true
 #define DEFAULT_BATTERY_ALARM 36
 #define DEFAULT_LOW_CALIBRATED_RSSI 0
 #define DEFAULT_HIGH_CALIBRATED_RSSI 4095
+#define DEFAULT_TUNED 0  // Not auto-tuned, use compiled-in settle time and samples
+#define DEFAULT_RSSI_OFFSET 0
+#define DEFAULT_DELTA_THRESHOLD 8  // Values within this many adc units of last sent value aren't sent in delta frames
+#define MAX_DELTA_THRESHOLD 255
+#define MAX_RX5808_MODULES 4  // Most receivers supported, each with its own calibration offset
 
 // Holds the state for the settings and handles updates to options
 class Settings {
@@ -21,14 +32,26 @@ public:
   void loadSettingsStorage();
   void clearReset();
 
-  VariableCallback<int> scanIntervalIndex;
-  VariableRestricted<float> scanInterval;  // Should not be directly set outside class
-  VariableCallback<int> buzzerIndex;
-  VariableRestricted<bool> buzzer;  // Should not be directly set outside class
-  VariableCallback<int> batteryAlarmIndex;
-  VariableRestricted<int> batteryAlarm;  // Should not be directly set outside class
-  VariableCallback<int> lowCalibratedRssi;
-  VariableCallback<int> highCalibratedRssi;
+  // Atomic so reads don't need settingsMutex
+  // Take settingsMutex when setting to serialise callbacks and storage writes
+  AtomicVariableCallback<int> scanIntervalIndex;
+  AtomicVariableRestricted<int> scanIntervalKhz;  // Should not be directly set outside class
+  AtomicVariableCallback<int> sweepOrderIndex;      // Matches SweepOrder enum
+  AtomicVariableCallback<int> traceIndex;           // Matches TraceMode enum
+  AtomicVariableCallback<int> rangeStart;           // Custom range start in MHz
+  AtomicVariableCallback<int> rangeStop;            // Custom range stop in MHz
+  AtomicVariableCallback<int> rangeStep;            // Custom range step in MHz
+  AtomicVariableCallback<int> buzzerIndex;
+  AtomicVariableRestricted<bool> buzzer;  // Should not be directly set outside class
+  AtomicVariableCallback<int> batteryAlarmIndex;
+  AtomicVariableRestricted<int> batteryAlarm;  // Should not be directly set outside class
+  AtomicVariableCallback<int> lowCalibratedRssi;
+  AtomicVariableCallback<int> highCalibratedRssi;
+  AtomicVariableCallback<int> tunedSettleTime;  // Max settle time in us found by auto-tune
+  AtomicVariableCallback<int> tunedSamples;     // Rssi samples per frequency found by auto-tune
+  AtomicVariableCallback<int> rssiOffsets[MAX_RX5808_MODULES];  // Added to each module's readings to match first module
+  AtomicVariableCallback<int> deltaThreshold;  // Smallest change sent in delta frames is one more than this
+  AtomicVariableRestricted<uint32_t> revision;  // Increases by one with every change saved, should not be directly set outside class
 
   SemaphoreHandle_t settingsMutex;
 
@@ -0,0 +1,170 @@
+#include "transport.h"
+#include "soc/gpio_reg.h"
+
+// Combine address, write bit and data into single frame sent LSB first
+static uint32_t registerFrame(byte address, unsigned long data) {
+  return (address & 0x0F) | (1 << 4) | ((data & 0xFFFFF) << 5);
+}
+
+GpioTransport::GpioTransport(uint8_t data, uint8_t le, uint8_t clk)
+  : dataPin(data), lePin(le), clkPin(clk) {}
+
+// Setup spi pins and inital state
+bool GpioTransport::begin() {
+  pinMode(dataPin, OUTPUT);
+  pinMode(lePin, OUTPUT);
+  pinMode(clkPin, OUTPUT);
+
+  digitalWrite(lePin, HIGH);
+  digitalWrite(clkPin, LOW);
+
+  return true;
+}
+
+// Send data to specified receiver register
+void GpioTransport::sendRegister(byte address, unsigned long data) {
+  // Begin transmission
+  digitalWrite(lePin, LOW);
+
+  // Send address (LSB)
+  for (int i = 0; i < 4; i++) {
+    sendBit(bitRead(address, i));
+  }
+
+  // Set to write mode
+  sendBit(1);
+
+  // Send data bits (LSB)
+  for (int i = 0; i < 20; i++) {
+    sendBit(bitRead(data, i));
+  }
+
+  // End transmission
+  digitalWrite(lePin, HIGH);
+}
+
+const char *GpioTransport::name() {
+  return "gpio";
+}
+
+// Send 0 or 1 to receiver
+void GpioTransport::sendBit(bool bit) {
+  // Set data value
+  digitalWrite(dataPin, bit);
+
+  // Pulse clock
+  digitalWrite(clkPin, HIGH);
+  delayMicroseconds(10);
+  digitalWrite(clkPin, LOW);
+}
+
+FastGpioTransport::FastGpioTransport(uint8_t data, uint8_t le, uint8_t clk)
+  : dataPin(data), lePin(le), clkPin(clk),
+    dataMask(1UL << data), leMask(1UL << le), clkMask(1UL << clk) {}
+
+// Setup spi pins and inital state
+bool FastGpioTransport::begin() {
+  pinMode(dataPin, OUTPUT);
+  pinMode(lePin, OUTPUT);
+  pinMode(clkPin, OUTPUT);
+
+  REG_WRITE(GPIO_OUT_W1TS_REG, leMask);
+  REG_WRITE(GPIO_OUT_W1TC_REG, clkMask);
+
+  return true;
+}
+
+// Send data to specified receiver register
+void FastGpioTransport::sendRegister(byte address, unsigned long data) {
+  uint32_t frame = registerFrame(address, data);
+
+  // Begin transmission
+  REG_WRITE(GPIO_OUT_W1TC_REG, leMask);
+
+  for (int i = 0; i < 25; i++) {
+    // Set data value and let it settle before clock edge
+    REG_WRITE(bitRead(frame, i) ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, dataMask);
+    delayMicroseconds(FAST_GPIO_SETUP_DELAY);
+
+    // Pulse clock, holding low phase so next edge isn't too close
+    REG_WRITE(GPIO_OUT_W1TS_REG, clkMask);
+    delayMicroseconds(FAST_GPIO_CLOCK_DELAY);
+    REG_WRITE(GPIO_OUT_W1TC_REG, clkMask);
+    delayMicroseconds(FAST_GPIO_CLOCK_DELAY);
+  }
+
+  // End transmission
+  REG_WRITE(GPIO_OUT_W1TS_REG, leMask);
+}
+
+const char *FastGpioTransport::name() {
+  return "fast_gpio";
+}
+
+bool SpiTransport::busReady = false;
+
+SpiTransport::SpiTransport(uint8_t data, uint8_t le, uint8_t clk)
+  : dataPin(data), lePin(le), clkPin(clk), device(NULL), transactionPending(false) {}
+
+// Attach receiver to spi bus
+// Can't be done in constructor as driver needs scheduler running
+bool SpiTransport::begin() {
+  if (!busReady) {
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = dataPin;
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = clkPin;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = 4;
+
+    // Invalid state means something else already set the bus up
+    esp_err_t err = spi_bus_initialize(RX5808_SPI_HOST, &bus, SPI_DMA_DISABLED);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false;
+    busReady = true;
+  }
+
+  // Mode 0 latches data on rising clock edge, same as bit-banged transports
+  spi_device_interface_config_t config = {};
+  config.mode = 0;
+  config.clock_speed_hz = RX5808_SPI_CLOCK;
+  config.spics_io_num = lePin;
+  config.flags = SPI_DEVICE_TXBIT_LSBFIRST | SPI_DEVICE_HALFDUPLEX;
+  config.queue_size = 1;
+  if (spi_bus_add_device(RX5808_SPI_HOST, &config, &device) != ESP_OK) {
+    device = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+// Queue frame to specified receiver register
+void SpiTransport::sendRegister(byte address, unsigned long data) {
+  if (device == NULL) return;
+
+  // Collect previous frame before reusing transaction
+  if (transactionPending) {
+    spi_transaction_t *done;
+    spi_device_get_trans_result(device, &done, portMAX_DELAY);
+    transactionPending = false;
+  }
+
+  uint32_t frame = registerFrame(address, data);
+
+  transaction = {};
+  transaction.flags = SPI_TRANS_USE_TXDATA;
+  transaction.length = 25;
+  transaction.tx_data[0] = frame & 0xFF;
+  transaction.tx_data[1] = (frame >> 8) & 0xFF;
+  transaction.tx_data[2] = (frame >> 16) & 0xFF;
+  transaction.tx_data[3] = (frame >> 24) & 0xFF;
+
+  if (spi_device_queue_trans(device, &transaction, portMAX_DELAY) == ESP_OK) {
+    transactionPending = true;
+  }
+}
+
+const char *SpiTransport::name() {
+  return "spi";
+}
@@ -0,0 +1,78 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <Arduino.h>
+#include "driver/spi_master.h"
+
+#define FAST_GPIO_CLOCK_DELAY 1  // Clock high and low time in us for direct gpio writes
+#define FAST_GPIO_SETUP_DELAY 1  // Data setup time in us before rising clock edge
+#define RX5808_SPI_HOST SPI2_HOST
+#define RX5808_SPI_CLOCK 500000  // Hz
+
+// Sends 25 bit register frames to an RX5808 over its 3-wire bus
+// Frame is 4 address bits, 1 write bit, then 20 data bits, all LSB first
+// begin() returns false if the bus couldn't be set up
+class RegisterTransport {
+public:
+  virtual bool begin() = 0;
+  virtual void sendRegister(byte address, unsigned long data) = 0;
+  virtual const char *name() = 0;  // Reported in stats alongside retune timings
+};
+
+// Bit-banged using digitalWrite(), slowest but simplest
+class GpioTransport : public RegisterTransport {
+public:
+  GpioTransport(uint8_t data, uint8_t le, uint8_t clk);
+  bool begin() override;
+  void sendRegister(byte address, unsigned long data) override;
+  const char *name() override;
+
+private:
+  void sendBit(bool bit);
+
+  uint8_t dataPin;
+  uint8_t lePin;
+  uint8_t clkPin;
+};
+
+// Bit-banged using direct gpio set/clear register writes with tight timing
+class FastGpioTransport : public RegisterTransport {
+public:
+  FastGpioTransport(uint8_t data, uint8_t le, uint8_t clk);
+  bool begin() override;
+  void sendRegister(byte address, unsigned long data) override;
+  const char *name() override;
+
+private:
+  uint8_t dataPin;
+  uint8_t lePin;
+  uint8_t clkPin;
+
+  uint32_t dataMask;
+  uint32_t leMask;
+  uint32_t clkMask;
+};
+
+// Driven by hardware spi peripheral with le as chip select
+// Frames are queued so the cpu is released while the bus clocks out
+class SpiTransport : public RegisterTransport {
+public:
+  SpiTransport(uint8_t data, uint8_t le, uint8_t clk);
+  bool begin() override;
+  void sendRegister(byte address, unsigned long data) override;
+  const char *name() override;
+
+private:
+  uint8_t dataPin;
+  uint8_t lePin;
+  uint8_t clkPin;
+
+  spi_device_handle_t device;
+  spi_transaction_t transaction;
+  bool transactionPending;
+
+  // Bus is shared by all modules, only initialised by first transport
+  static bool busReady;
+};
+
+#endif
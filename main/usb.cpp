@@ -10,6 +10,10 @@ UsbSerial::UsbSerial(Settings *s, RX5808 *r)
 {
   serialBufferPos = 0;
   serialBufferOverflow = false;
+  finderStreaming = false;
+  finderStreamNext = 0;
+  valuesStreaming = false;
+  valuesStreamedGeneration = 0;
 }
 
 // Start serial connection
@@ -29,10 +33,20 @@ void UsbSerial::flushIncoming() {
   while (Serial.available()) {
     Serial.read();
   }
+
+  // Client must ask to stream again after returning to usb menu
+  finderStreaming = false;
+  valuesStreaming = false;
 }
 
 // Start listening for commands
 void UsbSerial::listen() {
+  // Send any finder readings taken since last call
+  if (finderStreaming) finderStreamNext = sendFinder(finderStreamNext, true);
+
+  // Send sweep published since last call
+  if (valuesStreaming) sendDelta();
+
   while (Serial.available()) {
     const char c = Serial.read();
 
@@ -109,11 +123,13 @@ void UsbSerial::listen() {
     }
 
 #ifdef BATTERY_MONITORING
-    // Ensure only values, settings, calibration, battery and ping are accepted as location
+    // Ensure only values, settings, calibration, battery, stats, finder, peaks, history and ping are accepted as location
     if (strcmp(doc["location"], "values") != 0 && strcmp(doc["location"], "settings") != 0
         && strcmp(doc["location"], "calibration") != 0 && strcmp(doc["location"], "battery") != 0
+        && strcmp(doc["location"], "stats") != 0 && strcmp(doc["location"], "finder") != 0
+        && strcmp(doc["location"], "peaks") != 0 && strcmp(doc["location"], "history") != 0
         && strcmp(doc["location"], "ping") != 0) {
-      sendError("", "'location' must be 'values', 'settings', 'calibration', 'battery', or 'ping'");
+      sendError("", "'location' must be 'values', 'settings', 'calibration', 'battery', 'stats', 'finder', 'peaks', 'history', or 'ping'");
       return;
     }
 
@@ -123,14 +139,34 @@ void UsbSerial::listen() {
       return;
     }
 #else
-    // Ensure only values, settings and calibration are accepted as location
+    // Ensure only values, settings, calibration, stats, finder, peaks, history and ping are accepted as location
     if (strcmp(doc["location"], "values") != 0 && strcmp(doc["location"], "settings") != 0
-        && strcmp(doc["location"], "calibration") != 0 && strcmp(doc["location"], "ping") != 0) {
-      sendError("", "'location' must be 'values', 'settings', 'calibration', or 'ping'");
+        && strcmp(doc["location"], "calibration") != 0 && strcmp(doc["location"], "stats") != 0
+        && strcmp(doc["location"], "finder") != 0 && strcmp(doc["location"], "peaks") != 0
+        && strcmp(doc["location"], "history") != 0 && strcmp(doc["location"], "ping") != 0) {
+      sendError("", "'location' must be 'values', 'settings', 'calibration', 'stats', 'finder', 'peaks', 'history', or 'ping'");
       return;
     }
 #endif
 
+    // No post endpoint for stats
+    if (strcmp(doc["event"], "post") == 0 && strcmp(doc["location"], "stats") == 0) {
+      sendError("", "invalid event 'post' for location 'stats'");
+      return;
+    }
+
+    // No post endpoint for peaks
+    if (strcmp(doc["event"], "post") == 0 && strcmp(doc["location"], "peaks") == 0) {
+      sendError("", "invalid event 'post' for location 'peaks'");
+      return;
+    }
+
+    // No post endpoint for history
+    if (strcmp(doc["event"], "post") == 0 && strcmp(doc["location"], "history") == 0) {
+      sendError("", "invalid event 'post' for location 'history'");
+      return;
+    }
+
     // No post endpoint for ping
     if (strcmp(doc["event"], "post") == 0 && strcmp(doc["location"], "ping") == 0) {
       sendError("", "invalid event 'post' for location 'ping'");
@@ -157,19 +193,24 @@ void UsbSerial::handleGet(JsonDocument &doc) {
     return;
   }
 
-  // Payload must be empty
-  if (doc["payload"].size() != 0) {
+  // Payload must be empty, except for optional parameters when getting values, finder readings or history
+  if (doc["payload"].size() != 0 && strcmp(doc["location"], "values") != 0 && strcmp(doc["location"], "finder") != 0
+      && strcmp(doc["location"], "history") != 0) {
     sendError("", "'payload' object must be empty for 'get' event");
     return;
   }
 
   // Run correct function based on location
-  if (strcmp(doc["location"], "values") == 0) handleGetValues();
+  if (strcmp(doc["location"], "values") == 0) handleGetValues(doc);
   if (strcmp(doc["location"], "settings") == 0) handleGetSettings();
   if (strcmp(doc["location"], "calibration") == 0) handleGetCalibration();
 #ifdef BATTERY_MONITORING
   if (strcmp(doc["location"], "battery") == 0) handleGetBattery();
 #endif
+  if (strcmp(doc["location"], "stats") == 0) handleGetStats();
+  if (strcmp(doc["location"], "finder") == 0) handleGetFinder(doc);
+  if (strcmp(doc["location"], "peaks") == 0) handleGetPeaks();
+  if (strcmp(doc["location"], "history") == 0) handleGetHistory(doc);
   if (strcmp(doc["location"], "ping") == 0) handleGetPing();
 }
 
@@ -191,72 +232,161 @@ void UsbSerial::handlePost(JsonDocument &doc) {
   if (strcmp(doc["location"], "values") == 0) handlePostValues(doc);
   if (strcmp(doc["location"], "settings") == 0) handlePostSettings(doc);
   if (strcmp(doc["location"], "calibration") == 0) handlePostCalibration(doc);
+  if (strcmp(doc["location"], "finder") == 0) handlePostFinder(doc);
 }
 
 // Enpoint for getting scanned values
 // These values aren't actual rssi values, rather the analog-to-digital converter reading
 // Will be within a range of 0 to 4095 inclusive
-void UsbSerial::handleGetValues() {
+// Set 'timestamps' to true in payload to also get time each value was scanned
+// Set 'trace' to 'max', 'min' or 'average' in payload to get held or averaged values instead of latest readings
+void UsbSerial::handleGetValues(JsonDocument &req) {
+  // Only timestamps and trace keys allowed
+  for (JsonPair kv : req["payload"].as<JsonObject>()) {
+    const char *key = kv.key().c_str();
+    if (strcmp(key, "timestamps") != 0 && strcmp(key, "trace") != 0) {
+      sendError("values", "only 'timestamps' and 'trace' keys are allowed");
+      return;
+    }
+  }
+
+  // Check key type
+  if (req["payload"]["timestamps"].is<JsonVariant>() && !req["payload"]["timestamps"].is<bool>()) {
+    sendError("values", "'timestamps' must be a boolean");
+    return;
+  }
+
+  // Check trace type and value
+  TraceMode trace = LIVE;
+  if (req["payload"]["trace"].is<JsonVariant>()) {
+    if (!req["payload"]["trace"].is<const char *>() || !parseTrace(req["payload"]["trace"], trace)) {
+      sendError("values", "'trace' must be 'live', 'max', 'min' or 'average'");
+      return;
+    }
+  }
+
+  bool timestamps = req["payload"]["timestamps"] | false;
+
   JsonDocument doc;
 
   // Set headers
   doc["event"] = "get";
   doc["location"] = "values";
 
-  // Safely get lowband state
-  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-  bool lowband = receiver->lowband.get();
-  xSemaphoreGive(receiver->lowbandMutex);
+  // Borrow latest complete sweep so all values are from the same pass
+  const Sweep *sweep = receiver->borrowSweep();
 
   // Payload object
   JsonObject payload = doc["payload"].to<JsonObject>();
 
   // Add frequency information to payload
-  int min_freq = lowband ? LOWBAND_MIN_FREQUENCY : HIGHBAND_MIN_FREQUENCY;
-  payload["lowband"] = lowband;
-  payload["min_frequency"] = min_freq;
-  payload["max_frequency"] = min_freq + SCAN_FREQUENCY_RANGE;
-
-  // Calculate number of scanned values based off interval
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
-  float interval = settings->scanInterval.get();
-  xSemaphoreGive(settings->settingsMutex);
-  int numScannedValues = (SCAN_FREQUENCY_RANGE / interval) + 1;  // +1 for final number inclusion
+  payload["lowband"] = sweep->plan.lowband;
+  payload["min_frequency"] = sweep->plan.minFrequency;
+  payload["max_frequency"] = sweep->plan.maxFrequency;
+  payload["interval_khz"] = sweep->plan.intervalKhz;
+  payload["focus"] = sweep->plan.mode == FOCUS;
+  payload["generation"] = sweep->generation;
+  payload["timestamp"] = sweep->timestamp;
+  payload["complete"] = sweep->complete;
+  payload["trace"] = traceName(trace);
+
+  // Add time waited for rssi to settle on last step
+  payload["settle_time"] = receiver->settleTime.get();
 
   // Create values array in payload
   JsonArray values = payload["values"].to<JsonArray>();
 
   // Get receiver values
-  for (int i = 0; i < numScannedValues; i++) {
-    int rssi;
-    xSemaphoreTake(receiver->scanMutex, portMAX_DELAY);
-    rssi = receiver->rssiValues.get(i);
-    xSemaphoreGive(receiver->scanMutex);
+  for (int i = 0; i < sweep->plan.length; i++) {
+    values.add(sweep->trace(trace, i));
+  }
 
-    values.add(rssi);
+  // Channel table isn't evenly spaced, so give frequency and name of each value
+  if (sweep->plan.mode == CHANNELS) {
+    JsonArray frequencies = payload["frequencies"].to<JsonArray>();
+    JsonArray channels = payload["channels"].to<JsonArray>();
+    for (int i = 0; i < sweep->plan.length; i++) {
+      frequencies.add(sweep->plan.frequency(i));
+      channels.add(sweep->plan.channel(i));
+    }
   }
 
+  // Time each value was last scanned, may differ greatly in priority sweep order
+  if (timestamps) {
+    JsonArray updated = payload["updated"].to<JsonArray>();
+    for (int i = 0; i < sweep->plan.length; i++) {
+      updated.add(sweep->updated.get(i));
+    }
+  }
+
+  receiver->returnSweep(sweep);
+
   sendJson(doc);
 }
 
-// Endpoint for setting high or low band
+// Endpoint for setting high or low band, focusing on a frequency, restarting traces, and streaming sweeps
 void UsbSerial::handlePostValues(JsonDocument &doc) {
-  // Check keys
-  if (doc["payload"].size() != 1 || !doc["payload"]["lowband"].is<JsonVariant>()) {
-    sendError("values", "'lowband' must be the only key");
+  // Only lowband, focus, reset_traces and stream keys allowed, at least one required
+  if (doc["payload"].size() == 0) {
+    sendError("values", "only 'lowband', 'focus', 'reset_traces' and 'stream' keys are allowed");
     return;
   }
+  for (JsonPair kv : doc["payload"].as<JsonObject>()) {
+    const char *key = kv.key().c_str();
+    if (strcmp(key, "lowband") != 0 && strcmp(key, "focus") != 0 && strcmp(key, "reset_traces") != 0 && strcmp(key, "stream") != 0) {
+      sendError("values", "only 'lowband', 'focus', 'reset_traces' and 'stream' keys are allowed");
+      return;
+    }
+  }
 
-  // Check key type
-  if (!doc["payload"]["lowband"].is<bool>()) {
+  // Check lowband type
+  if (doc["payload"]["lowband"].is<JsonVariant>() && !doc["payload"]["lowband"].is<bool>()) {
     sendError("values", "'lowband' must be a boolean");
     return;
   }
 
-  // Update receiver lowband state
-  xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
-  receiver->lowband.set(doc["payload"]["lowband"]);
-  xSemaphoreGive(receiver->lowbandMutex);
+  // Check reset_traces type
+  if (doc["payload"]["reset_traces"].is<JsonVariant>() && !doc["payload"]["reset_traces"].is<bool>()) {
+    sendError("values", "'reset_traces' must be a boolean");
+    return;
+  }
+
+  // Check stream type
+  if (doc["payload"]["stream"].is<JsonVariant>() && !doc["payload"]["stream"].is<bool>()) {
+    sendError("values", "'stream' must be a boolean");
+    return;
+  }
+
+  // Check focus type and value, 0 returns to full sweep
+  if (doc["payload"]["focus"].is<JsonVariant>()) {
+    if (!doc["payload"]["focus"].is<int>()) {
+      sendError("values", "'focus' must be an integer");
+      return;
+    }
+    int focus = doc["payload"]["focus"];
+    if (focus != 0 && (focus < RX5808_MIN_FREQUENCY || focus > RX5808_MAX_FREQUENCY)) {
+      sendError("values", "'focus' must be 0 or between 5300 and 6000 inclusive");
+      return;
+    }
+  }
+
+  // Update receiver lowband and focus state
+  if (doc["payload"]["lowband"].is<JsonVariant>() || doc["payload"]["focus"].is<JsonVariant>()) {
+    xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+    if (doc["payload"]["lowband"].is<JsonVariant>()) receiver->lowband.set(doc["payload"]["lowband"]);
+    if (doc["payload"]["focus"].is<JsonVariant>()) receiver->focusFrequency.set(doc["payload"]["focus"]);
+    xSemaphoreGive(receiver->lowbandMutex);
+    receiver->reconfigure();
+  }
+
+  if (doc["payload"]["reset_traces"] == true) receiver->resetTraces();
+
+  // Streaming starts with a keyframe of latest sweep
+  if (doc["payload"]["stream"].is<JsonVariant>()) {
+    valuesStreaming = doc["payload"]["stream"];
+    valuesStreamedGeneration = 0;
+    deltaEncoder.requestKeyframe();
+  }
 
   JsonDocument resp;
 
@@ -269,7 +399,9 @@ void UsbSerial::handlePostValues(JsonDocument &doc) {
 }
 
 // Endpoint for getting settings indices
-// Scan interval settings { 2.5, 5, 10 }
+// Scan interval settings { 2.5, 5, 10, Channels, Custom }
+// Sweep order settings { Linear, Bit-reversed, Interleaved, Priority }
+// Trace settings { Live, Max hold, Min hold, Average }
 // Buzzer settings { On, Off }
 // Battery alarm settings { 3.6, 3.3, 3.0 }
 void UsbSerial::handleGetSettings() {
@@ -279,40 +411,45 @@ void UsbSerial::handleGetSettings() {
   doc["event"] = "get";
   doc["location"] = "settings";
 
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   doc["payload"]["scan_interval_index"] = settings->scanIntervalIndex.get();
-  doc["payload"]["scan_interval"] = settings->scanInterval.get();
+  doc["payload"]["scan_interval"] = settings->scanIntervalKhz.get() / 1000.0;
+  doc["payload"]["sweep_order_index"] = settings->sweepOrderIndex.get();
+  doc["payload"]["trace_index"] = settings->traceIndex.get();
+  doc["payload"]["range_start"] = settings->rangeStart.get();
+  doc["payload"]["range_stop"] = settings->rangeStop.get();
+  doc["payload"]["range_step"] = settings->rangeStep.get();
+  doc["payload"]["delta_threshold"] = settings->deltaThreshold.get();
   doc["payload"]["buzzer_index"] = settings->buzzerIndex.get();
   doc["payload"]["buzzer"] = settings->buzzer.get();
 #ifdef BATTERY_MONITORING
   doc["payload"]["battery_alarm_index"] = settings->batteryAlarmIndex.get();
   doc["payload"]["battery_alarm"] = settings->batteryAlarm.get();
 #endif
-  xSemaphoreGive(settings->settingsMutex);
 
   sendJson(doc);
 }
 
 // Endpoint for updating settings indices
-// Scan interval settings { 2.5, 5, 10 }
+// Scan interval settings { 2.5, 5, 10, Channels, Custom }
+// Sweep order settings { Linear, Bit-reversed, Interleaved, Priority }
 // Buzzer settings { On, Off }
 // Battery alarm settings { 3.6, 3.3, 3.0 }
 void UsbSerial::handlePostSettings(JsonDocument &doc) {
 #ifdef BATTERY_MONITORING
-  // Only scan_interval_index, buzzer_index and battery_alarm_index keys allowed
+  // Only scan_interval_index, sweep_order_index, trace_index, range_start, range_stop, range_step, delta_threshold, buzzer_index and battery_alarm_index keys allowed
   for (JsonPair kv : doc["payload"].as<JsonObject>()) {
     const char *key = kv.key().c_str();
-    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "buzzer_index") != 0 && strcmp(key, "battery_alarm_index") != 0) {
-      sendError("settings", "only 'scan_interval_index', 'buzzer_index' and 'battery_alarm_index' keys are allowed");
+    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "sweep_order_index") != 0 && strcmp(key, "trace_index") != 0 && strcmp(key, "range_start") != 0 && strcmp(key, "range_stop") != 0 && strcmp(key, "range_step") != 0 && strcmp(key, "delta_threshold") != 0 && strcmp(key, "buzzer_index") != 0 && strcmp(key, "battery_alarm_index") != 0) {
+      sendError("settings", "only 'scan_interval_index', 'sweep_order_index', 'trace_index', 'range_start', 'range_stop', 'range_step', 'delta_threshold', 'buzzer_index' and 'battery_alarm_index' keys are allowed");
       return;
     }
   }
 #else
-  // Only scan_interval_index and buzzer_index keys allowed
+  // Only scan_interval_index, sweep_order_index, trace_index, range_start, range_stop, range_step, delta_threshold and buzzer_index keys allowed
   for (JsonPair kv : doc["payload"].as<JsonObject>()) {
     const char *key = kv.key().c_str();
-    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "buzzer_index") != 0) {
-      sendError("settings", "only 'scan_interval_index' and 'buzzer_index' keys are allowed");
+    if (strcmp(key, "scan_interval_index") != 0 && strcmp(key, "sweep_order_index") != 0 && strcmp(key, "trace_index") != 0 && strcmp(key, "range_start") != 0 && strcmp(key, "range_stop") != 0 && strcmp(key, "range_step") != 0 && strcmp(key, "delta_threshold") != 0 && strcmp(key, "buzzer_index") != 0) {
+      sendError("settings", "only 'scan_interval_index', 'sweep_order_index', 'trace_index', 'range_start', 'range_stop', 'range_step', 'delta_threshold' and 'buzzer_index' keys are allowed");
       return;
     }
   }
@@ -324,8 +461,75 @@ void UsbSerial::handlePostSettings(JsonDocument &doc) {
       sendError("settings", "'scan_interval_index' must be an integer");
       return;
     }
-    if (doc["payload"]["scan_interval_index"] < 0 || doc["payload"]["scan_interval_index"] > 2) {
-      sendError("settings", "'scan_interval_index' must be between 0 and 2 inclusive");
+    if (doc["payload"]["scan_interval_index"] < 0 || doc["payload"]["scan_interval_index"] > 4) {
+      sendError("settings", "'scan_interval_index' must be between 0 and 4 inclusive");
+      return;
+    }
+  }
+
+  // Validate type and value of sweep_order_index
+  if (doc["payload"]["sweep_order_index"].is<JsonVariant>()) {
+    if (!doc["payload"]["sweep_order_index"].is<int>()) {
+      sendError("settings", "'sweep_order_index' must be an integer");
+      return;
+    }
+    if (doc["payload"]["sweep_order_index"] < 0 || doc["payload"]["sweep_order_index"] > 3) {
+      sendError("settings", "'sweep_order_index' must be between 0 and 3 inclusive");
+      return;
+    }
+  }
+
+  // Validate type and value of trace_index
+  if (doc["payload"]["trace_index"].is<JsonVariant>()) {
+    if (!doc["payload"]["trace_index"].is<int>()) {
+      sendError("settings", "'trace_index' must be an integer");
+      return;
+    }
+    if (doc["payload"]["trace_index"] < 0 || doc["payload"]["trace_index"] > 3) {
+      sendError("settings", "'trace_index' must be between 0 and 3 inclusive");
+      return;
+    }
+  }
+
+  // Validate type of range_start
+  if (doc["payload"]["range_start"].is<JsonVariant>() && !doc["payload"]["range_start"].is<int>()) {
+    sendError("settings", "'range_start' must be an integer");
+    return;
+  }
+
+  // Validate type of range_stop
+  if (doc["payload"]["range_stop"].is<JsonVariant>() && !doc["payload"]["range_stop"].is<int>()) {
+    sendError("settings", "'range_stop' must be an integer");
+    return;
+  }
+
+  // Validate type of range_step
+  if (doc["payload"]["range_step"].is<JsonVariant>() && !doc["payload"]["range_step"].is<int>()) {
+    sendError("settings", "'range_step' must be an integer");
+    return;
+  }
+
+  // Validate custom range, missing keys keep current value
+  int rangeStart = doc["payload"]["range_start"] | settings->rangeStart.get();
+  int rangeStop = doc["payload"]["range_stop"] | settings->rangeStop.get();
+  int rangeStep = doc["payload"]["range_step"] | settings->rangeStep.get();
+  if (rangeStart < RX5808_MIN_FREQUENCY || rangeStop > RX5808_MAX_FREQUENCY || rangeStart >= rangeStop) {
+    sendError("settings", "'range_start' must be less than 'range_stop', both between 5300 and 6000 inclusive");
+    return;
+  }
+  if (rangeStep < 1 || rangeStep > rangeStop - rangeStart) {
+    sendError("settings", "'range_step' must be between 1 and the width of the range inclusive");
+    return;
+  }
+
+  // Validate type and value of delta_threshold
+  if (doc["payload"]["delta_threshold"].is<JsonVariant>()) {
+    if (!doc["payload"]["delta_threshold"].is<int>()) {
+      sendError("settings", "'delta_threshold' must be an integer");
+      return;
+    }
+    if (doc["payload"]["delta_threshold"] < 0 || doc["payload"]["delta_threshold"] > MAX_DELTA_THRESHOLD) {
+      sendError("settings", "'delta_threshold' must be between 0 and 255 inclusive");
       return;
     }
   }
@@ -361,10 +565,34 @@ void UsbSerial::handlePostSettings(JsonDocument &doc) {
     xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
     settings->scanIntervalIndex.set(doc["payload"]["scan_interval_index"]);
     xSemaphoreGive(settings->settingsMutex);
+  }
+  if (doc["payload"]["sweep_order_index"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->sweepOrderIndex.set(doc["payload"]["sweep_order_index"]);
+    xSemaphoreGive(settings->settingsMutex);
+  }
+  if (doc["payload"]["trace_index"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->traceIndex.set(doc["payload"]["trace_index"]);
+    xSemaphoreGive(settings->settingsMutex);
+    receiver->resetTraces();
+  }
+  if (doc["payload"]["range_start"].is<JsonVariant>() || doc["payload"]["range_stop"].is<JsonVariant>() || doc["payload"]["range_step"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->rangeStart.set(rangeStart);
+    settings->rangeStop.set(rangeStop);
+    settings->rangeStep.set(rangeStep);
+    xSemaphoreGive(settings->settingsMutex);
+  }
 
-    // Need to restart scanning for interval update to work
-    receiver->stopScan();
-    receiver->startScan();
+  // Scanning picks up new interval, order and range from next step
+  if (doc["payload"]["scan_interval_index"].is<JsonVariant>() || doc["payload"]["sweep_order_index"].is<JsonVariant>() || doc["payload"]["range_start"].is<JsonVariant>() || doc["payload"]["range_stop"].is<JsonVariant>() || doc["payload"]["range_step"].is<JsonVariant>()) {
+    receiver->reconfigure();
+  }
+  if (doc["payload"]["delta_threshold"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    settings->deltaThreshold.set(doc["payload"]["delta_threshold"]);
+    xSemaphoreGive(settings->settingsMutex);
   }
   if (doc["payload"]["buzzer_index"].is<JsonVariant>()) {
     xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
@@ -400,10 +628,19 @@ void UsbSerial::handleGetCalibration() {
   doc["event"] = "get";
   doc["location"] = "calibration";
 
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   doc["payload"]["low_rssi"] = settings->lowCalibratedRssi.get();
   doc["payload"]["high_rssi"] = settings->highCalibratedRssi.get();
-  xSemaphoreGive(settings->settingsMutex);
+
+  // Auto-tuned dwell and samples, 0 if not tuned
+  doc["payload"]["settle_time"] = settings->tunedSettleTime.get();
+  doc["payload"]["rssi_samples"] = settings->tunedSamples.get();
+  doc["payload"]["auto_tuning"] = receiver->autoTuning.get();
+
+  // Added to readings from each module so they match first module
+  JsonArray offsets = doc["payload"]["rssi_offsets"].to<JsonArray>();
+  for (int i = 0; i < receiver->getModules(); i++) {
+    offsets.add(settings->rssiOffsets[i].get());
+  }
 
   sendJson(doc);
 }
@@ -411,20 +648,19 @@ void UsbSerial::handleGetCalibration() {
 // Endpoint for setting high and low calibration values
 // Must be within a range of 0 to 4095 inclusive, with low value less than high value
 void UsbSerial::handlePostCalibration(JsonDocument &doc) {
-  // Only high_rssi and low_rssi keys allowed
+  // Only high_rssi, low_rssi, auto_tune and rssi_offsets keys allowed
   for (JsonPair kv : doc["payload"].as<JsonObject>()) {
     const char *key = kv.key().c_str();
-    if (strcmp(key, "high_rssi") != 0 && strcmp(key, "low_rssi") != 0) {
-      sendError("calibration", "only 'high_rssi' and 'low_rssi' keys are allowed");
+    if (strcmp(key, "high_rssi") != 0 && strcmp(key, "low_rssi") != 0 && strcmp(key, "auto_tune") != 0
+        && strcmp(key, "rssi_offsets") != 0) {
+      sendError("calibration", "only 'high_rssi', 'low_rssi', 'auto_tune' and 'rssi_offsets' keys are allowed");
       return;
     }
   }
 
   // Safely get calibrated rssi values
-  xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
   int newHigh = settings->highCalibratedRssi.get();
   int newLow = settings->lowCalibratedRssi.get();
-  xSemaphoreGive(settings->settingsMutex);
 
   // Validate type and value of high_rssi
   if (doc["payload"]["high_rssi"].is<JsonVariant>()) {
@@ -452,6 +688,26 @@ void UsbSerial::handlePostCalibration(JsonDocument &doc) {
     }
   }
 
+  // Validate type of auto_tune
+  if (doc["payload"]["auto_tune"].is<JsonVariant>() && !doc["payload"]["auto_tune"].is<bool>()) {
+    sendError("calibration", "'auto_tune' must be a boolean");
+    return;
+  }
+
+  // Validate rssi_offsets, one for each module
+  if (doc["payload"]["rssi_offsets"].is<JsonVariant>()) {
+    if (!doc["payload"]["rssi_offsets"].is<JsonArray>() || doc["payload"]["rssi_offsets"].size() != (size_t)receiver->getModules()) {
+      sendError("calibration", "'rssi_offsets' must be an array with an offset for each module");
+      return;
+    }
+    for (JsonVariant offset : doc["payload"]["rssi_offsets"].as<JsonArray>()) {
+      if (!offset.is<int>() || offset.as<int>() < -4095 || offset.as<int>() > 4095) {
+        sendError("calibration", "'rssi_offsets' must be integers between -4095 and 4095 inclusive");
+        return;
+      }
+    }
+  }
+
   // high_rssi must be greater than low_rssi
   if (newHigh <= newLow) {
     sendError("calibration", "'high_rssi' must be greater than 'low_rssi' (considering new or existing values)");
@@ -470,6 +726,17 @@ void UsbSerial::handlePostCalibration(JsonDocument &doc) {
     xSemaphoreGive(settings->settingsMutex);
   }
 
+  if (doc["payload"]["rssi_offsets"].is<JsonVariant>()) {
+    xSemaphoreTake(settings->settingsMutex, portMAX_DELAY);
+    for (int i = 0; i < receiver->getModules(); i++) {
+      settings->rssiOffsets[i].set(doc["payload"]["rssi_offsets"][i]);
+    }
+    xSemaphoreGive(settings->settingsMutex);
+  }
+
+  // Scanning task runs auto-tune in background, poll auto_tuning to see when finished
+  if (doc["payload"]["auto_tune"] | false) receiver->requestAutoTune();
+
   JsonDocument resp;
 
   // Set headers
@@ -489,14 +756,263 @@ void UsbSerial::handleGetBattery() {
   doc["event"] = "get";
   doc["location"] = "battery";
 
-  xSemaphoreTake(battery->batteryMutex, portMAX_DELAY);
   doc["payload"]["voltage"] = battery->currentVoltage.get();
-  xSemaphoreGive(battery->batteryMutex);
 
   sendJson(doc);
 }
 #endif
 
+// Endpoint for getting transmitters found in complete sweeps
+// Peaks keep the same id while tracked, times in ms since boot
+void UsbSerial::handleGetPeaks() {
+  JsonDocument doc;
+
+  // Set headers
+  doc["event"] = "get";
+  doc["location"] = "peaks";
+
+  PeakList list = receiver->getPeaks();
+
+  doc["payload"]["generation"] = list.generation;
+  doc["payload"]["noise_floor"] = list.noiseFloor;
+
+  JsonArray peaks = doc["payload"]["peaks"].to<JsonArray>();
+  for (int i = 0; i < list.length; i++) {
+    JsonObject peak = peaks.add<JsonObject>();
+    peak["id"] = list.peaks[i].id;
+    peak["frequency"] = list.peaks[i].frequency;
+    peak["bandwidth_khz"] = list.peaks[i].bandwidthKhz;
+    peak["rssi"] = list.peaks[i].rssi;
+    peak["prominence"] = list.peaks[i].prominence;
+    peak["first_seen"] = list.peaks[i].firstSeen;
+    peak["last_seen"] = list.peaks[i].lastSeen;
+  }
+
+  sendJson(doc);
+}
+
+// Endpoint for getting complete sweeps kept in history, oldest first
+// Set 'from' and 'to' in payload to only get sweeps published in that range, in ms since boot
+// Readings are quantised to 8 bits and sent as 2 hex digits each
+void UsbSerial::handleGetHistory(JsonDocument &req) {
+  // Only from and to keys allowed
+  for (JsonPair kv : req["payload"].as<JsonObject>()) {
+    const char *key = kv.key().c_str();
+    if (strcmp(key, "from") != 0 && strcmp(key, "to") != 0) {
+      sendError("history", "only 'from' and 'to' keys are allowed");
+      return;
+    }
+  }
+
+  // Check key types
+  if (req["payload"]["from"].is<JsonVariant>() && !req["payload"]["from"].is<uint32_t>()) {
+    sendError("history", "'from' must be a non-negative integer");
+    return;
+  }
+  if (req["payload"]["to"].is<JsonVariant>() && !req["payload"]["to"].is<uint32_t>()) {
+    sendError("history", "'to' must be a non-negative integer");
+    return;
+  }
+
+  unsigned long from = req["payload"]["from"] | 0UL;
+  unsigned long to = req["payload"]["to"] | ULONG_MAX;
+
+  ScanPlan plan;
+  bool more;
+  int length = receiver->getHistory(from, to, historyRecords, HISTORY_RESPONSE_SWEEPS, historyValues, HISTORY_RESPONSE_BYTES, plan, more);
+
+  JsonDocument doc;
+
+  // Set headers
+  doc["event"] = "get";
+  doc["location"] = "history";
+
+  // Add frequency information to json
+  doc["payload"]["lowband"] = plan.lowband;
+  doc["payload"]["min_frequency"] = plan.minFrequency;
+  doc["payload"]["max_frequency"] = plan.maxFrequency;
+  doc["payload"]["interval_khz"] = plan.intervalKhz;
+  doc["payload"]["focus"] = plan.mode == FOCUS;
+  doc["payload"]["shift"] = HISTORY_SHIFT;
+  doc["payload"]["more"] = more;
+
+  // Channel table isn't evenly spaced, so give frequency of each value
+  if (plan.mode == CHANNELS) {
+    JsonArray frequencies = doc["payload"]["frequencies"].to<JsonArray>();
+    for (int i = 0; i < plan.length; i++) {
+      frequencies.add(plan.frequency(i));
+    }
+  }
+
+  JsonArray sweeps = doc["payload"]["sweeps"].to<JsonArray>();
+  for (int i = 0; i < length; i++) {
+    for (int j = 0; j < plan.length; j++) {
+      snprintf(&historyHex[j * 2], 3, "%02x", historyValues[i * plan.length + j]);
+    }
+    historyHex[plan.length * 2] = '\0';
+
+    JsonObject sweep = sweeps.add<JsonObject>();
+    sweep["generation"] = historyRecords[i].generation;
+    sweep["timestamp"] = historyRecords[i].timestamp;
+    sweep["values"] = historyHex;
+  }
+
+  sendJson(doc);
+}
+
+// Endpoint for getting scan timing statistics since last reconfigure
+// All times in us
+void UsbSerial::handleGetStats() {
+  JsonDocument doc;
+
+  // Set headers
+  doc["event"] = "get";
+  doc["location"] = "stats";
+
+  ScanStats stats = receiver->getStats();
+
+  doc["payload"]["steps"] = stats.steps;
+  doc["payload"]["mean_jitter"] = stats.steps > 0 ? stats.totalJitter / stats.steps : 0;
+  doc["payload"]["max_jitter"] = stats.maxJitter;
+  doc["payload"]["sweeps"] = stats.sweeps;
+  doc["payload"]["last_sweep_period"] = stats.lastSweepPeriod;
+  doc["payload"]["min_sweep_period"] = stats.minSweepPeriod;
+  doc["payload"]["max_sweep_period"] = stats.maxSweepPeriod;
+  doc["payload"]["mean_sweep_period"] = stats.sweeps > 0 ? stats.totalSweepPeriod / stats.sweeps : 0;
+  doc["payload"]["transport"] = stats.transport;
+  doc["payload"]["mean_retune_time"] = stats.retunes > 0 ? stats.totalRetuneTime / stats.retunes : 0;
+  doc["payload"]["max_retune_time"] = stats.maxRetuneTime;
+  doc["payload"]["stack_free"] = stats.stackFree;
+
+  sendJson(doc);
+}
+
+// Endpoint for getting finder readings
+// Set 'after' in payload to only get readings numbered after or equal to it, using 'next' from previous response
+void UsbSerial::handleGetFinder(JsonDocument &req) {
+  // Only after key allowed
+  for (JsonPair kv : req["payload"].as<JsonObject>()) {
+    if (strcmp(kv.key().c_str(), "after") != 0) {
+      sendError("finder", "only 'after' key is allowed");
+      return;
+    }
+  }
+
+  // Check key type
+  if (req["payload"]["after"].is<JsonVariant>() && !req["payload"]["after"].is<uint32_t>()) {
+    sendError("finder", "'after' must be a non-negative integer");
+    return;
+  }
+
+  sendFinder(req["payload"]["after"] | 0, false);
+}
+
+// Endpoint for starting finder on a frequency or stopping with 0, and streaming readings
+void UsbSerial::handlePostFinder(JsonDocument &doc) {
+  // Only frequency and stream keys allowed
+  for (JsonPair kv : doc["payload"].as<JsonObject>()) {
+    const char *key = kv.key().c_str();
+    if (strcmp(key, "frequency") != 0 && strcmp(key, "stream") != 0) {
+      sendError("finder", "only 'frequency' and 'stream' keys are allowed");
+      return;
+    }
+  }
+
+  // Check frequency type and value
+  if (doc["payload"]["frequency"].is<JsonVariant>()) {
+    if (!doc["payload"]["frequency"].is<int>()) {
+      sendError("finder", "'frequency' must be an integer");
+      return;
+    }
+    int frequency = doc["payload"]["frequency"];
+    if (frequency != 0 && (frequency < RX5808_MIN_FREQUENCY || frequency > RX5808_MAX_FREQUENCY)) {
+      sendError("finder", "'frequency' must be 0 or between 5300 and 6000 inclusive");
+      return;
+    }
+  }
+
+  // Check stream type
+  if (doc["payload"]["stream"].is<JsonVariant>() && !doc["payload"]["stream"].is<bool>()) {
+    sendError("finder", "'stream' must be a boolean");
+    return;
+  }
+
+  // Update receiver finder state
+  if (doc["payload"]["frequency"].is<JsonVariant>()) {
+    xSemaphoreTake(receiver->lowbandMutex, portMAX_DELAY);
+    receiver->finderFrequency.set(doc["payload"]["frequency"]);
+    xSemaphoreGive(receiver->lowbandMutex);
+    receiver->reconfigure();
+  }
+
+  // Streaming starts from oldest reading still held
+  if (doc["payload"]["stream"].is<JsonVariant>()) {
+    finderStreaming = doc["payload"]["stream"];
+    finderStreamNext = 0;
+  }
+
+  JsonDocument resp;
+
+  // Set headers
+  resp["event"] = "post";
+  resp["location"] = "finder";
+  resp["payload"]["status"] = "ok";
+
+  sendJson(resp);
+}
+
+// Send finder readings numbered after or equal to given reading
+// Returns number of next reading to send
+uint32_t UsbSerial::sendFinder(uint32_t after, bool onlyIfNew) {
+  uint32_t first;
+  int length = receiver->getFinderTrace(finderTrace, FINDER_TRACE_LENGTH, after, first);
+
+  if (onlyIfNew && length == 0) return after;
+
+  JsonDocument doc;
+
+  // Set headers
+  doc["event"] = "get";
+  doc["location"] = "finder";
+
+  doc["payload"]["frequency"] = receiver->finderFrequency.get();
+  doc["payload"]["rssi"] = receiver->finderRssi.get();
+  doc["payload"]["first"] = first;
+  doc["payload"]["next"] = first + length;
+
+  JsonArray values = doc["payload"]["trace"].to<JsonArray>();
+  for (int i = 0; i < length; i++) {
+    values.add(finderTrace[i]);
+  }
+
+  sendJson(doc);
+  return first + length;
+}
+
+// Send latest sweep as keyframe or delta frame from delta.h, if published since last sent
+void UsbSerial::sendDelta() {
+  const Sweep *sweep = receiver->borrowSweep();
+  if (sweep->generation == 0 || sweep->generation == valuesStreamedGeneration) {
+    receiver->returnSweep(sweep);
+    return;
+  }
+  valuesStreamedGeneration = sweep->generation;
+  size_t length = deltaEncoder.encode(sweep, receiver->settleTime.get(), settings->deltaThreshold.get(), deltaFrame, sizeof(deltaFrame));
+  receiver->returnSweep(sweep);
+
+  base64Encode(deltaFrame, length, deltaBase64);
+
+  JsonDocument doc;
+
+  // Set headers
+  doc["event"] = "get";
+  doc["location"] = "values";
+
+  doc["payload"]["frame"] = deltaBase64;
+
+  sendJson(doc);
+}
+
 // Endpoint for pinging device
 // Used as a connectivity check
 void UsbSerial::handleGetPing() {
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "battery.h"
+#include "delta.h"
 #include "RX5808.h"
 #include "settings.h"
 
@@ -26,7 +27,7 @@ public:
 private:
   void handleGet(JsonDocument &doc);
   void handlePost(JsonDocument &doc);
-  void handleGetValues();
+  void handleGetValues(JsonDocument &req);
   void handlePostValues(JsonDocument &doc);
   void handleGetSettings();
   void handlePostSettings(JsonDocument &doc);
@@ -35,6 +36,13 @@ private:
 #ifdef BATTERY_MONITORING
   void handleGetBattery();
 #endif
+  void handleGetStats();
+  void handleGetPeaks();
+  void handleGetHistory(JsonDocument &req);
+  void handleGetFinder(JsonDocument &req);
+  void handlePostFinder(JsonDocument &doc);
+  uint32_t sendFinder(uint32_t after, bool onlyIfNew);
+  void sendDelta();
   void handleGetPing();
   void sendJson(JsonDocument &doc);
   void sendError(const char *location, const char *msg);
@@ -46,6 +54,25 @@ private:
   int serialBufferPos;
   bool serialBufferOverflow;
 
+  // Finder readings pushed on every listen() when streaming
+  bool finderStreaming;
+  uint32_t finderStreamNext;
+
+  // Sweeps pushed on every listen() as delta frames when streaming, base64 encoded to fit json
+  bool valuesStreaming;
+  uint32_t valuesStreamedGeneration;
+  DeltaEncoder deltaEncoder;
+  uint8_t deltaFrame[PACKED_MAX_SIZE];
+  char deltaBase64[BASE64_LENGTH(PACKED_MAX_SIZE) + 1];
+
+  // History copied for responses, too big for loop stack
+  HistoryRecord historyRecords[HISTORY_RESPONSE_SWEEPS];
+  uint8_t historyValues[HISTORY_RESPONSE_BYTES];
+  char historyHex[MAX_FREQUENCIES_SCANNED * 2 + 1];
+
+  // Finder readings copied for responses, too big for loop stack
+  uint16_t finderTrace[FINDER_TRACE_LENGTH];
+
   Settings *settings;
   RX5808 *receiver;
 #ifdef BATTERY_MONITORING
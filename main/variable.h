@@ -1,44 +1,92 @@
 #ifndef VARIABLE_H
 #define VARIABLE_H
 
+#include <atomic>
+#include <functional>
+
 // Declare classes to friend them
 class Battery;
 class RX5808;
 class Settings;
 
-// Base Variable class with get() and set() access
-template<typename T> class Variable {
+// Heap-allocated array variable sized at runtime, with restricted set() access
+// Only reallocates when growing past largest size so far
+template<typename T> class VariableBufferRestricted {
+public:
+  VariableBufferRestricted()
+    : values(nullptr), size(0), capacity(0) {}
+
+  ~VariableBufferRestricted() {
+    delete[] values;
+  }
+
+  VariableBufferRestricted(const VariableBufferRestricted &) = delete;
+  VariableBufferRestricted &operator=(const VariableBufferRestricted &) = delete;
+
+  T get(size_t index) const {
+    return values[index];
+  }
+
+  size_t length() const {
+    return size;
+  }
+
+private:
+  void set(size_t index, T newValue) {
+    values[index] = newValue;
+  }
+
+  // Change length, values must all be set again afterwards
+  void resize(size_t newSize) {
+    if (newSize > capacity) {
+      delete[] values;
+      values = new T[newSize]();
+      capacity = newSize;
+    }
+    size = newSize;
+  }
+
+  T *values;
+  size_t size;
+  size_t capacity;
+
+  // Allow classes to access set() and resize()
+  friend class RX5808;
+};
+
+// Variable backed by an atomic for wait-free get() and set() without a mutex
+// Non-virtual so reads compile down to a single load
+// Only suitable for small types (bool, int, float, etc.)
+template<typename T> class AtomicVariable {
 public:
-  Variable(T initialValue = T())
+  AtomicVariable(T initialValue = T())
     : value(initialValue) {}
 
-  virtual void set(T newValue) {
-    value = newValue;
+  void set(T newValue) {
+    value.store(newValue, std::memory_order_release);
   }
 
-  virtual T get() const {
-    return value;
+  T get() const {
+    return value.load(std::memory_order_acquire);
   }
 
 protected:
-  T value;
+  std::atomic<T> value;
 };
 
-// Variable that runs callback function when value changed
-// Most useful for settings variables that need to have side effect when updated
+// Atomic variable that runs callback function when value changed
 // Callback only called when value changes
-template<typename T> class VariableCallback : public Variable<T> {
+// Writers should still be serialised if callback has side effects
+template<typename T> class AtomicVariableCallback : public AtomicVariable<T> {
 public:
   using Callback = std::function<void(T)>;
 
-  VariableCallback(T initialValue = T())
-    : Variable<T>(initialValue), callback(nullptr) {}
+  AtomicVariableCallback(T initialValue = T())
+    : AtomicVariable<T>(initialValue), callback(nullptr) {}
 
-  void set(T newValue) override {
-    if (newValue != this->value) {
-      this->value = newValue;
-      if (callback) callback(this->value);
-    }
+  void set(T newValue) {
+    T oldValue = this->value.exchange(newValue, std::memory_order_acq_rel);
+    if (newValue != oldValue && callback) callback(newValue);
   }
 
 private:
@@ -52,48 +100,19 @@ private:
   friend class Settings;
 };
 
-// Variable with restricted set() access
-template<typename T> class VariableRestricted : public Variable<T> {
+// Atomic variable with restricted set() access
+template<typename T> class AtomicVariableRestricted : public AtomicVariable<T> {
 public:
-  VariableRestricted(T initialValue = T())
-    : Variable<T>(initialValue) {}
+  AtomicVariableRestricted(T initialValue = T())
+    : AtomicVariable<T>(initialValue) {}
 
 private:
-  void set(T newValue) override {
-    this->value = newValue;
-  }
+  using AtomicVariable<T>::set;
 
   // Allow classes to access set()
   friend class Battery;
-  friend class Settings;
-};
-
-// Array variable with restricted set() access
-template<typename T, size_t N> class VariableArrayRestricted {
-public:
-  VariableArrayRestricted(T initialValue = T()) {
-    for (size_t i = 0; i < N; i++) {
-      values[i] = initialValue;
-    }
-  }
-
-  T get(size_t index) const {
-    return values[index];
-  }
-
-  size_t length() const {
-    return N;
-  }
-
-private:
-  void set(size_t index, T newValue) {
-    values[index] = newValue;
-  }
-
-  T values[N];
-
-  // Allow classes to access set()
   friend class RX5808;
+  friend class Settings;
 };
 
 #endif